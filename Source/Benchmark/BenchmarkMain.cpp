@@ -0,0 +1,407 @@
+#include "../DSP/FFTProcessor.h"
+#include "../DSP/SpectralChain.h"
+#include "../DSP/WindowSizes.h"
+#include "../Utility/overSampleGain.h"
+#include <iostream>
+#include <map>
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+/*
+  krush-bench: times the spectral hot paths outside a host.
+
+    krush-bench [--filter <text>] [--output <json>] [--baseline <json>] [--threshold <percent>]
+
+  Three kinds of case, each on the same seeded noise and sines every run:
+
+    spectral  FFTProcessor with the chain's crush as its callback, for every order,
+              overlap order, crush, channel count and host block size
+    crush     the crush kernel alone on one frame, per order, crush and grouping
+    gain      overSampleGain::process, per oversampling factor and soft clip
+
+  Every case reports ns per input sample and, where the CPU has a timestamp counter,
+  cycles per hop (per frame for the crush kernel, which runs once a hop). Each is the
+  median of several timed runs after a warm up.
+
+  With --baseline, each case is compared with the case of the same name in an earlier
+  --output file, and the exit code is 1 if any got slower by more than the threshold.
+ */
+
+namespace
+{
+    constexpr int numRuns = 7;
+    constexpr int sampleRate = 48000;
+    constexpr double defaultThreshold = 10.0;
+    const juce::StringArray groupingNames{"linear", "log", "bark"};
+
+    struct Case
+    {
+        juce::String kind;
+        juce::NamedValueSet parameters;
+
+        // kind/parameter=value/..., which is how results are matched with the baseline.
+        juce::String getName() const
+        {
+            auto name = kind;
+            for (const auto& parameter : parameters)
+                name << "/" << parameter.name.toString() << "=" << parameter.value.toString();
+            return name;
+        }
+    };
+
+    struct Result
+    {
+        Case benchCase;
+        double nsPerSample = 0.0;
+        double cyclesPerHop = -1.0;
+    };
+
+    juce::int64 readCycleCounter()
+    {
+       #if JUCE_INTEL
+        return (juce::int64) __rdtsc();
+       #else
+        return -1;
+       #endif
+    }
+
+    // Noise under a few sines, so the crush has tonal peaks and a floor to work on.
+    juce::AudioBuffer<float> makeSignal(int numChannels, int numSamples)
+    {
+        juce::AudioBuffer<float> signal(numChannels, numSamples);
+        juce::Random random(0x6b72757368);
+
+        for (int c = 0; c < numChannels; ++c)
+        {
+            auto* data = signal.getWritePointer(c);
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto t = (double) i / sampleRate;
+                data[i] = 0.05f * (random.nextFloat() * 2.0f - 1.0f)
+                        + (float) (0.3 * std::sin(juce::MathConstants<double>::twoPi * 110.0 * (c + 1) * t)
+                                 + 0.2 * std::sin(juce::MathConstants<double>::twoPi * 1375.0 * t)
+                                 + 0.1 * std::sin(juce::MathConstants<double>::twoPi * 7040.0 * t));
+            }
+        }
+
+        return signal;
+    }
+
+    // Runs body once to warm up, then numRuns times, and keeps the median run. Cases
+    // without hops pass 0 for samplesPerHop.
+    template <typename Body>
+    void measure(Result& result, juce::int64 samplesPerRun, double samplesPerHop, Body&& body)
+    {
+        body();
+
+        std::vector<std::pair<double, double>> runs;
+        for (int run = 0; run < numRuns; ++run)
+        {
+            const auto startCycles = readCycleCounter();
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+            body();
+            const auto ticks = juce::Time::getHighResolutionTicks() - startTicks;
+            const auto cycles = readCycleCounter() - startCycles;
+
+            const auto ns = juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9;
+            runs.emplace_back(ns / (double) samplesPerRun, startCycles < 0 ? -1.0 : (double) cycles / (double) samplesPerRun);
+        }
+
+        std::sort(runs.begin(), runs.end());
+        const auto& median = runs[runs.size() / 2];
+        result.nsPerSample = median.first;
+        result.cyclesPerHop = median.second < 0.0 || samplesPerHop <= 0.0 ? -1.0 : median.second * samplesPerHop;
+    }
+
+    SpectralModuleSpec makeSpec(int fftSize, int hopSize, int numChannels)
+    {
+        SpectralModuleSpec spec;
+        spec.bandSizes = {fftSize};
+        spec.bandHops = {hopSize};
+        spec.numChannels = numChannels;
+        spec.sampleRate = sampleRate;
+        return spec;
+    }
+
+    Result runSpectral(const Case& benchCase)
+    {
+        const int order = benchCase.parameters["order"];
+        const int overlap = benchCase.parameters["overlap"];
+        const int crush = benchCase.parameters["crush"];
+        const int numChannels = benchCase.parameters["channels"];
+        const int blockSize = benchCase.parameters["block"];
+
+        const auto fftSize = 1 << order;
+        FFTProcessor processor(fftSize, overlap, numChannels, numChannels);
+        const auto hopSize = processor.getHopSize();
+
+        SpectralChain chain;
+        chain.prepare(makeSpec(fftSize, hopSize, numChannels));
+        chain.setParameter(SpectralChain::Parameter::crush, (float) crush);
+
+        // Enough for a good number of hops even at the largest windows.
+        const auto numSamples = juce::jmax(1 << 17, 32 * hopSize);
+        const auto input = makeSignal(numChannels, numSamples);
+        juce::AudioBuffer<float> output(numChannels, blockSize);
+
+        Result result{benchCase};
+        const float* blockInput[16];
+        measure(result, numSamples, hopSize, [&]
+        {
+            for (int start = 0; start < numSamples; start += blockSize)
+            {
+                const auto numToProcess = juce::jmin(blockSize, numSamples - start);
+                for (int c = 0; c < numChannels; ++c)
+                    blockInput[c] = input.getReadPointer(c) + start;
+
+                processor.process(blockInput, output.getArrayOfWritePointers(), numToProcess, false,
+                                  [&chain](SpectralFrame& frame) { chain.process(frame); });
+            }
+        });
+
+        return result;
+    }
+
+    Result runCrushKernel(const Case& benchCase)
+    {
+        const int order = benchCase.parameters["order"];
+        const int crush = benchCase.parameters["crush"];
+        const auto grouping = static_cast<SpectralCrush::Grouping>(groupingNames.indexOf(benchCase.parameters["grouping"].toString()));
+        const int numChannels = benchCase.parameters["channels"];
+
+        const auto fftSize = 1 << order;
+        const auto hopSize = fftSize / 4;
+        const auto numBins = fftSize / 2 + 1;
+        const auto stride = SpectralFrame::strideForChannels(numChannels);
+
+        SpectralCrush kernel;
+        kernel.prepare(makeSpec(fftSize, hopSize, numChannels));
+        kernel.setCrush(crush);
+        kernel.setGrouping(grouping);
+
+        // A fresh copy of the same spectrum goes in every time.
+        std::vector<float> sourceReal((size_t) (numBins * stride)), sourceImag(sourceReal.size());
+        juce::Random random(0x6b72757368);
+        for (int bin = 0; bin < numBins; ++bin)
+        {
+            for (int c = 0; c < numChannels; ++c)
+            {
+                const auto magnitude = (float) fftSize / (4.0f * (1.0f + (float) bin));
+                const auto phase = random.nextFloat() * juce::MathConstants<float>::twoPi;
+                sourceReal[(size_t) (bin * stride + c)] = magnitude * std::cos(phase);
+                sourceImag[(size_t) (bin * stride + c)] = magnitude * std::sin(phase);
+            }
+        }
+
+        std::vector<float> real(sourceReal.size()), imag(sourceReal.size()), magnitude(sourceReal.size());
+        SpectralFrame frame;
+        frame.real = real.data();
+        frame.imag = imag.data();
+        frame.magnitude = magnitude.data();
+        frame.numBins = numBins;
+        frame.endBin = numBins;
+        frame.numChannels = numChannels;
+        frame.stride = stride;
+
+        Result result{benchCase};
+        const auto framesPerRun = juce::jmax(16, (1 << 22) / fftSize);
+        measure(result, (juce::int64) framesPerRun * hopSize, hopSize, [&]
+        {
+            for (int f = 0; f < framesPerRun; ++f)
+            {
+                std::copy(sourceReal.begin(), sourceReal.end(), real.begin());
+                std::copy(sourceImag.begin(), sourceImag.end(), imag.begin());
+                kernel.process(frame);
+            }
+        });
+
+        return result;
+    }
+
+    Result runGain(const Case& benchCase)
+    {
+        const int oversampling = benchCase.parameters["oversampling"];
+        const bool softClip = benchCase.parameters["clip"];
+        const int numChannels = benchCase.parameters["channels"];
+        const int blockSize = benchCase.parameters["block"];
+
+        overSampleGain gain;
+        gain.prepare(numChannels, blockSize);
+        gain.setFactorIndex(juce::roundToInt(std::log2(oversampling)));
+
+        const auto numSamples = 1 << 17;
+        auto signal = makeSignal(numChannels, numSamples);
+
+        Result result{benchCase};
+        juce::dsp::AudioBlock<float> block(signal);
+        measure(result, numSamples, 0.0, [&]
+        {
+            for (int start = 0; start < numSamples; start += blockSize)
+            {
+                auto subBlock = block.getSubBlock((size_t) start, (size_t) juce::jmin(blockSize, numSamples - start));
+                gain.process(subBlock, 0.0f, softClip);
+            }
+        });
+
+        return result;
+    }
+
+    juce::var toJSON(const juce::Array<Result>& results)
+    {
+        juce::Array<juce::var> cases;
+        for (const auto& result : results)
+        {
+            auto* object = new juce::DynamicObject();
+            object->setProperty("name", result.benchCase.getName());
+            for (const auto& parameter : result.benchCase.parameters)
+                object->setProperty(parameter.name, parameter.value);
+            object->setProperty("ns_per_sample", result.nsPerSample);
+            if (result.cyclesPerHop >= 0.0)
+                object->setProperty("cycles_per_hop", result.cyclesPerHop);
+            cases.add(juce::var(object));
+        }
+
+        auto* root = new juce::DynamicObject();
+        root->setProperty("cpu", juce::SystemStats::getCpuModel());
+        root->setProperty("cases", cases);
+        return juce::var(root);
+    }
+
+    // Prints every case that got more than threshold percent slower and returns how many did.
+    int compareWithBaseline(const juce::Array<Result>& results, const juce::var& baseline, double threshold)
+    {
+        std::map<juce::String, double> baselineTimes;
+        if (auto* cases = baseline["cases"].getArray())
+            for (const auto& entry : *cases)
+                baselineTimes[entry["name"].toString()] = (double) entry["ns_per_sample"];
+
+        int numRegressions = 0;
+        for (const auto& result : results)
+        {
+            const auto name = result.benchCase.getName();
+            const auto found = baselineTimes.find(name);
+            if (found == baselineTimes.end() || found->second <= 0.0)
+                continue;
+
+            const auto change = 100.0 * (result.nsPerSample / found->second - 1.0);
+            if (change > threshold)
+            {
+                ++numRegressions;
+                std::cout << "REGRESSION " << name << ": " << found->second << " -> " << result.nsPerSample
+                          << " ns/sample (+" << juce::String(change, 1) << "%)\n";
+            }
+        }
+
+        return numRegressions;
+    }
+
+    void printUsage()
+    {
+        std::cout << "Usage: krush-bench [options]\n"
+                     "  --filter <text>          only run cases whose name contains text\n"
+                     "  --output <file>          write the results as JSON\n"
+                     "  --baseline <file>        compare with the JSON from an earlier run\n"
+                     "  --threshold <percent>    slowdown that counts as a regression (default: 10)\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::String filter;
+    juce::File outputFile, baselineFile;
+    auto threshold = defaultThreshold;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        const auto hasValue = i + 1 < argc;
+        auto value = [&] { return juce::String(argv[++i]); };
+
+        if (arg == "--filter" && hasValue)
+            filter = value();
+        else if (arg == "--output" && hasValue)
+            outputFile = juce::File::getCurrentWorkingDirectory().getChildFile(value());
+        else if (arg == "--baseline" && hasValue)
+            baselineFile = juce::File::getCurrentWorkingDirectory().getChildFile(value());
+        else if (arg == "--threshold" && hasValue)
+            threshold = value().getDoubleValue();
+        else
+        {
+            printUsage();
+            return arg == "-h" || arg == "--help" ? 0 : 2;
+        }
+    }
+
+    std::vector<Case> cases;
+    auto add = [&cases](const char* kind, std::initializer_list<juce::NamedValueSet::NamedValue> parameters)
+    {
+        cases.push_back({kind, juce::NamedValueSet(parameters)});
+    };
+
+    for (int order = WindowSizes::minOrder; order <= WindowSizes::maxOrder; ++order)
+        for (int overlap = WindowSizes::minOverlapOrder; overlap <= WindowSizes::maxOverlapOrder; ++overlap)
+            for (int crush : {1, 8, SpectralCrush::maxCrush})
+                for (int channels : {1, 2, 6})
+                    for (int block : {64, 512, 2048})
+                        add("spectral", {{"order", order}, {"overlap", overlap}, {"crush", crush}, {"channels", channels}, {"block", block}});
+
+    for (int order = WindowSizes::minOrder; order <= WindowSizes::maxOrder; ++order)
+        for (int crush : {1, 8, SpectralCrush::maxCrush})
+            for (const auto& grouping : groupingNames)
+                for (int channels : {1, 2, 6})
+                    add("crush", {{"order", order}, {"crush", crush}, {"grouping", grouping}, {"channels", channels}});
+
+    for (int oversampling : {1, 2, 4, 8})
+        for (int clip : {0, 1})
+            for (int channels : {1, 2, 6})
+                for (int block : {64, 512, 2048})
+                    add("gain", {{"oversampling", oversampling}, {"clip", clip}, {"channels", channels}, {"block", block}});
+
+    juce::Array<Result> results;
+    for (const auto& benchCase : cases)
+    {
+        if (filter.isNotEmpty() && !benchCase.getName().contains(filter))
+            continue;
+
+        if (benchCase.kind == "spectral")
+            results.add(runSpectral(benchCase));
+        else if (benchCase.kind == "crush")
+            results.add(runCrushKernel(benchCase));
+        else
+            results.add(runGain(benchCase));
+
+        const auto& result = results.getReference(results.size() - 1);
+        std::cout << benchCase.getName() << "  " << juce::String(result.nsPerSample, 3) << " ns/sample";
+        if (result.cyclesPerHop >= 0.0)
+            std::cout << "  " << juce::String(result.cyclesPerHop, 0) << " cycles/hop";
+        std::cout << "\n";
+    }
+
+    if (outputFile != juce::File() && !outputFile.replaceWithText(juce::JSON::toString(toJSON(results))))
+    {
+        std::cerr << "Can't write " << outputFile.getFullPathName() << "\n";
+        return 2;
+    }
+
+    if (baselineFile != juce::File())
+    {
+        const auto baseline = juce::JSON::parse(baselineFile);
+        if (!baseline.isObject())
+        {
+            std::cerr << "Can't read the baseline " << baselineFile.getFullPathName() << "\n";
+            return 2;
+        }
+
+        const auto numRegressions = compareWithBaseline(results, baseline, threshold);
+        std::cout << numRegressions << " regressions over " << threshold << "%\n";
+        return numRegressions == 0 ? 0 : 1;
+    }
+
+    return 0;
+}
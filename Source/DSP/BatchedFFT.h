@@ -0,0 +1,206 @@
+#pragma once
+#include "MixedRadixFFT.h"
+
+/*
+  Runs `lanes` real-only transforms of the same size at once. Each element of the packed
+  complex data holds that element's real parts for every lane, then its imaginary parts,
+  so every butterfly and twiddle multiply runs across the lanes as plain float vector
+  operations. The plan and the butterflies are MixedRadixFFT's, so each lane comes out the
+  same as a MixedRadixFFT run on its own, in the same in-place layout: size reals in,
+  size / 2 + 1 bins out, and back, scaled by 1 / size. Each lane's buffer needs size + 2
+  floats.
+ */
+class BatchedFFT
+{
+public:
+    using Complex = MixedRadixFFT::Complex;
+    static constexpr int lanes = 4;
+
+    explicit BatchedFFT(int size)
+        : plan(size), fftSize(size), halfSize(size / 2),
+          bufferA((size_t) halfSize), bufferB((size_t) halfSize)
+    {
+    }
+
+    int getSize() const { return fftSize; }
+
+    // Lanes past numLanes are run on zeros and left alone.
+    void performRealOnlyForwardTransform(float* const* data, int numLanes)
+    {
+        auto* z = bufferA.data();
+        for (int k = 0; k < halfSize; ++k)
+        {
+            for (int l = 0; l < lanes; ++l)
+            {
+                z[k].re.v[l] = l < numLanes ? data[l][2 * k] : 0.0f;
+                z[k].im.v[l] = l < numLanes ? data[l][2 * k + 1] : 0.0f;
+            }
+        }
+
+        const auto* result = runStages<false>();
+        const auto& realTwiddles = plan.getRealTwiddles();
+
+        for (int k = 0; k <= halfSize / 2; ++k)
+        {
+            const auto twiddle = realTwiddles[(size_t) k];
+            const auto a = result[k];
+            const auto b = conj(result[(halfSize - k) % halfSize]);
+            const auto even = 0.5f * (a + b);
+            const auto odd = rotate(0.5f * (a - b), false);
+            const auto low = even + twiddle * odd;
+            const auto high = conj(even - twiddle * odd);
+
+            for (int l = 0; l < numLanes; ++l)
+            {
+                auto* bins = data[l];
+                if (k == 0)
+                {
+                    bins[0] = result[0].re.v[l] + result[0].im.v[l];
+                    bins[1] = 0.0f;
+                    bins[2 * halfSize] = result[0].re.v[l] - result[0].im.v[l];
+                    bins[2 * halfSize + 1] = 0.0f;
+                    continue;
+                }
+
+                bins[2 * k] = low.re.v[l];
+                bins[2 * k + 1] = low.im.v[l];
+                bins[2 * (halfSize - k)] = high.re.v[l];
+                bins[2 * (halfSize - k) + 1] = high.im.v[l];
+            }
+        }
+    }
+
+    void performRealOnlyInverseTransform(float* const* data, int numLanes)
+    {
+        auto* z = bufferA.data();
+        const auto& realTwiddles = plan.getRealTwiddles();
+
+        for (int k = 0; k <= halfSize / 2; ++k)
+        {
+            LaneComplex a, b;
+            for (int l = 0; l < lanes; ++l)
+            {
+                const auto used = l < numLanes;
+                a.re.v[l] = used ? data[l][2 * k] : 0.0f;
+                a.im.v[l] = used ? data[l][2 * k + 1] : 0.0f;
+                b.re.v[l] = used ? data[l][2 * (halfSize - k)] : 0.0f;
+                b.im.v[l] = used ? -data[l][2 * (halfSize - k) + 1] : 0.0f;
+            }
+
+            const auto even = 0.5f * (a + b);
+            const auto odd = std::conj(realTwiddles[(size_t) k]) * rotate(0.5f * (a - b), true);
+
+            z[k] = even + odd;
+            if (k != 0 && k != halfSize - k)
+                z[halfSize - k] = conj(even - odd);
+        }
+
+        const auto* result = runStages<true>();
+        const auto scale = 1.0f / (float) halfSize;
+
+        for (int l = 0; l < numLanes; ++l)
+        {
+            for (int k = 0; k < halfSize; ++k)
+            {
+                data[l][2 * k] = result[k].re.v[l] * scale;
+                data[l][2 * k + 1] = result[k].im.v[l] * scale;
+            }
+        }
+    }
+
+private:
+    struct LaneFloat
+    {
+        float v[lanes];
+
+        friend LaneFloat operator+(LaneFloat a, LaneFloat b) { for (int l = 0; l < lanes; ++l) a.v[l] += b.v[l]; return a; }
+        friend LaneFloat operator-(LaneFloat a, LaneFloat b) { for (int l = 0; l < lanes; ++l) a.v[l] -= b.v[l]; return a; }
+        friend LaneFloat operator*(float s, LaneFloat a) { for (int l = 0; l < lanes; ++l) a.v[l] *= s; return a; }
+        friend LaneFloat operator-(LaneFloat a) { for (int l = 0; l < lanes; ++l) a.v[l] = -a.v[l]; return a; }
+    };
+
+    // One complex value per lane, in the shape MixedRadixFFT::butterfly expects.
+    struct LaneComplex
+    {
+        LaneFloat re{}, im{};
+
+        LaneComplex() = default;
+        LaneComplex(LaneFloat r, LaneFloat i) : re(r), im(i) {}
+
+        LaneFloat real() const { return re; }
+        LaneFloat imag() const { return im; }
+
+        friend LaneComplex operator+(const LaneComplex& a, const LaneComplex& b) { return {a.re + b.re, a.im + b.im}; }
+        friend LaneComplex operator-(const LaneComplex& a, const LaneComplex& b) { return {a.re - b.re, a.im - b.im}; }
+        friend LaneComplex operator*(float s, const LaneComplex& a) { return {s * a.re, s * a.im}; }
+
+        friend LaneComplex operator*(Complex w, const LaneComplex& a)
+        {
+            return {w.real() * a.re - w.imag() * a.im, w.real() * a.im + w.imag() * a.re};
+        }
+    };
+
+    static LaneComplex conj(const LaneComplex& a) { return {a.re, -a.im}; }
+
+    static LaneComplex rotate(const LaneComplex& a, bool inverse)
+    {
+        return MixedRadixFFT::rotate(a, inverse);
+    }
+
+    template <bool inverse>
+    const LaneComplex* runStages()
+    {
+        const auto& stages = plan.getStages();
+        for (size_t index = 0; index < stages.size(); ++index)
+        {
+            const auto* x = index % 2 == 0 ? bufferA.data() : bufferB.data();
+            auto* y = index % 2 == 0 ? bufferB.data() : bufferA.data();
+
+            switch (stages[index].radix)
+            {
+                case 4: butterflies<4, inverse>(stages[index], x, y); break;
+                case 2: butterflies<2, inverse>(stages[index], x, y); break;
+                case 3: butterflies<3, inverse>(stages[index], x, y); break;
+                case 5: butterflies<5, inverse>(stages[index], x, y); break;
+                default: jassertfalse; break;
+            }
+        }
+
+        return stages.size() % 2 == 0 ? bufferA.data() : bufferB.data();
+    }
+
+    template <int radix, bool inverse>
+    void butterflies(const MixedRadixFFT::Stage& stage, const LaneComplex* x, LaneComplex* y) const
+    {
+        const auto m = stage.length / radix;
+        const auto s = stage.stride;
+        const auto* w = plan.getTwiddles().data() + stage.twiddleOffset;
+
+        for (int p = 0; p < m; ++p)
+        {
+            Complex tw[radix];
+            tw[0] = {1.0f, 0.0f};
+            for (int k = 1; k < radix; ++k)
+                tw[k] = inverse ? std::conj(w[p * (radix - 1) + k - 1]) : w[p * (radix - 1) + k - 1];
+
+            for (int q = 0; q < s; ++q)
+            {
+                LaneComplex a[radix], b[radix];
+                for (int j = 0; j < radix; ++j)
+                    a[j] = x[q + s * (p + j * m)];
+
+                MixedRadixFFT::butterfly<radix, inverse>(a, b);
+
+                y[q + s * radix * p] = b[0];
+                for (int k = 1; k < radix; ++k)
+                    y[q + s * (radix * p + k)] = tw[k] * b[k];
+            }
+        }
+    }
+
+    MixedRadixFFT plan;
+    int fftSize, halfSize;
+    std::vector<LaneComplex> bufferA, bufferB;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BatchedFFT)
+};
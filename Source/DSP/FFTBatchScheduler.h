@@ -0,0 +1,205 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <thread>
+#include "BatchedFFT.h"
+
+/*
+  Process-wide pool of FFT work shared by every Krush instance that opts in. It is held
+  through a juce::SharedResourcePointer, so all instances in the process get the same one.
+
+  Each FFTProcessor borrows slots from the pool of its size. It fills a slot, submits it,
+  and only collects the result a hop later. Hosts usually run every instance at a graph
+  level one after another on the same thread, so by then the other instances have
+  submitted their frames for the same window too. The first instance to collect runs
+  every submitted slot of that size, lanes at a time, through one BatchedFFT and hands
+  each result back in place. The others find theirs already done.
+
+  Slots are only created on the message thread (acquireSlot) and are never freed while
+  the scheduler lives, so the audio threads never allocate or wait on a lock. If another
+  thread is already running a batch of the same size, complete() spins until it can run
+  the batch itself or finds its slot done. That is bounded by the cost of one batch.
+ */
+class FFTBatchScheduler
+{
+public:
+    static constexpr int maxSlotsPerSize = 1024;
+
+    enum class Direction { forward, inverse };
+
+    class Pool;
+
+    class Slot
+    {
+    public:
+        // size + 2 floats, in MixedRadixFFT's real-only layout.
+        float* getData() { return data.data(); }
+
+    private:
+        friend class FFTBatchScheduler;
+
+        Slot(Pool& owner, int fftSize) : pool(owner), data((size_t) fftSize + 2) {}
+
+        Pool& pool;
+        std::vector<float> data;
+        std::atomic<int> state{0};
+        Direction direction = Direction::forward;
+    };
+
+    class Pool
+    {
+    private:
+        friend class FFTBatchScheduler;
+
+        explicit Pool(int size) : fftSize(size), fft(size) {}
+
+        int fftSize;
+        BatchedFFT fft;
+        std::array<std::unique_ptr<Slot>, maxSlotsPerSize> slots;
+        std::atomic<int> numSlots{0};
+        std::atomic<bool> running{false};
+    };
+
+    FFTBatchScheduler() = default;
+
+    // Returns nullptr when the size can't be batched or its pool is full.
+    Slot* acquireSlot(int fftSize)
+    {
+        if (!MixedRadixFFT::isSupportedSize(fftSize))
+            return nullptr;
+
+        const juce::ScopedLock lock(poolLock);
+
+        auto& pool = getPool(fftSize);
+        const auto numSlots = pool.numSlots.load(std::memory_order_relaxed);
+
+        for (int i = 0; i < numSlots; ++i)
+        {
+            auto expected = unused;
+            if (pool.slots[(size_t) i]->state.compare_exchange_strong(expected, idle, std::memory_order_acq_rel))
+                return pool.slots[(size_t) i].get();
+        }
+
+        if (numSlots == maxSlotsPerSize)
+            return nullptr;
+
+        pool.slots[(size_t) numSlots].reset(new Slot(pool, fftSize));
+        pool.slots[(size_t) numSlots]->state.store(idle, std::memory_order_relaxed);
+        pool.numSlots.store(numSlots + 1, std::memory_order_release);
+        return pool.slots[(size_t) numSlots].get();
+    }
+
+    // Hands a slot back, waiting out a batch that is still running on it.
+    void releaseSlot(Slot* slot)
+    {
+        if (slot == nullptr)
+            return;
+
+        for (;;)
+        {
+            auto state = slot->state.load(std::memory_order_acquire);
+            if (state == claimed)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            if (slot->state.compare_exchange_weak(state, unused, std::memory_order_acq_rel))
+                return;
+        }
+    }
+
+    void submit(Slot& slot, Direction direction)
+    {
+        jassert(slot.state.load(std::memory_order_relaxed) == idle);
+        slot.direction = direction;
+        slot.state.store(submitted, std::memory_order_release);
+    }
+
+    // Blocks until the slot's transform has run, running the batch here if nobody has yet.
+    void complete(Slot& slot)
+    {
+        auto& pool = slot.pool;
+
+        while (slot.state.load(std::memory_order_acquire) != done)
+        {
+            if (!pool.running.exchange(true, std::memory_order_acquire))
+            {
+                runSubmitted(pool);
+                pool.running.store(false, std::memory_order_release);
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        slot.state.store(idle, std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr int unused = 0, idle = 1, submitted = 2, claimed = 3, done = 4;
+    static constexpr int lanes = BatchedFFT::lanes;
+
+    struct Batch
+    {
+        std::array<Slot*, lanes> slots{};
+        std::array<float*, lanes> data{};
+        int size = 0;
+    };
+
+    Pool& getPool(int fftSize)
+    {
+        for (auto& pool : pools)
+            if (pool->fftSize == fftSize)
+                return *pool;
+
+        pools.push_back(std::unique_ptr<Pool>(new Pool(fftSize)));
+        return *pools.back();
+    }
+
+    static void runSubmitted(Pool& pool)
+    {
+        Batch forward, inverse;
+        const auto numSlots = pool.numSlots.load(std::memory_order_acquire);
+
+        for (int i = 0; i < numSlots; ++i)
+        {
+            auto& slot = *pool.slots[(size_t) i];
+            auto expected = submitted;
+            if (!slot.state.compare_exchange_strong(expected, claimed, std::memory_order_acq_rel))
+                continue;
+
+            auto& batch = slot.direction == Direction::forward ? forward : inverse;
+            batch.slots[(size_t) batch.size] = &slot;
+            batch.data[(size_t) batch.size] = slot.getData();
+
+            if (++batch.size == lanes)
+                runBatch(pool, batch, slot.direction);
+        }
+
+        runBatch(pool, forward, Direction::forward);
+        runBatch(pool, inverse, Direction::inverse);
+    }
+
+    static void runBatch(Pool& pool, Batch& batch, Direction direction)
+    {
+        if (batch.size == 0)
+            return;
+
+        if (direction == Direction::forward)
+            pool.fft.performRealOnlyForwardTransform(batch.data.data(), batch.size);
+        else
+            pool.fft.performRealOnlyInverseTransform(batch.data.data(), batch.size);
+
+        for (int l = 0; l < batch.size; ++l)
+            batch.slots[(size_t) l]->state.store(done, std::memory_order_release);
+
+        batch.size = 0;
+    }
+
+    juce::CriticalSection poolLock;
+    std::vector<std::unique_ptr<Pool>> pools;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FFTBatchScheduler)
+};
@@ -1,113 +1,606 @@
 #pragma once
 #include "juce_dsp/juce_dsp.h"
+#include "FFTBatchScheduler.h"
+#include "SpectralAnalysisCache.h"
+#include "SpectralFrame.h"
+#include "../Utility/PerformanceCounters.h"
 
 /*
-  Each channel should have its own FFTProcessor.
+  One FFTProcessor runs every channel of the bus. The FIFOs and the working frame are
+  channel-interleaved (sample i of channel c at [i * stride + c]) so windowing and
+  overlap-add run across channels a lane group at a time, and the spectra are handed to
+  process_fn as a SpectralFrame in the same layout. Each channel still gets its own
+  transform.
+
+  Only the first numSpectralChannels are transformed. Any channels after them still go
+  through the FIFOs and windows, so they come out delayed by exactly the same latency,
+  but skip the transforms and the spectral callback (the side channel of "Mid Only").
+
+  Power of two sizes run on juce::dsp::FFT, any other 2/3/5 size on MixedRadixFFT.
+
+  Windows above maxUnsplitSize are too expensive to transform inside the callback that
+  lands on a hop boundary, so their passes are spread evenly over the following hop and
+  the frame is overlap-added one hop later. That costs an extra hop of latency.
+
+  Given an FFTBatchScheduler, unsplit sizes hand their transforms to it instead. Each
+  frame's forward transforms are submitted when it is captured and collected a hop later,
+  when the spectral callback runs and the inverses are submitted, and those are collected
+  another hop later for the overlap-add. That gives the scheduler a whole hop to gather
+  other instances' frames into a batch, and costs two hops of latency.
+
+  Offline, a SpectralAnalysisCache can stand in for the forward transforms: recording
+  stores each frame's spectra just before the spectral callback, and replaying loads
+  them back at the same point instead of transforming.
  */
 class FFTProcessor
 {
 public:
-    FFTProcessor(int order, int overlapOrder) 
-        : fft(order), fftSize(1 << order), overlap(1 << overlapOrder),
-            hopSize(fftSize / overlap),
-            window(fftSize + 1, juce::dsp::WindowingFunction<float>::WindowingMethod::hann, false),
-            inputFifo(fftSize), outputFifo(fftSize), fftData(fftSize * 2)
+    static constexpr int maxUnsplitSize = 1 << 12;
+
+    FFTProcessor(int size, int overlapOrder, int channels, int spectralChannels, FFTBatchScheduler* batchScheduler = nullptr)
+        : fftSize(size), overlap(1 << overlapOrder),
+            hopSize(fftSize / overlap), numBins(fftSize / 2 + 1),
+            numChannels(channels), stride(SpectralFrame::strideForChannels(channels)),
+            numSpectralChannels(spectralChannels), spectralStride(SpectralFrame::strideForChannels(spectralChannels)),
+            splitTransform(size > maxUnsplitSize),
+            inputFifo(fftSize * stride), outputFifo(fftSize * stride), frameData(fftSize * stride),
+            realPlane(numBins * spectralStride), imagPlane(numBins * spectralStride), magnitudePlane(numBins * spectralStride)
+    {
+        if (juce::isPowerOfTwo(fftSize) && !splitTransform)
+        {
+            fft = std::make_unique<juce::dsp::FFT>(juce::roundToInt(std::log2(fftSize)));
+            channelDataSize = fftSize * 2;
+        }
+        else
+        {
+            // MixedRadixFFT only writes the non-negative bins, so it doesn't need juce's 2 * size.
+            mixedRadixFFT = std::make_unique<MixedRadixFFT>(fftSize);
+            channelDataSize = fftSize + 2;
+            numSplitSteps = (mixedRadixFFT->getNumPasses() * 2) * numSpectralChannels + 1;
+        }
+
+        jassert(numSpectralChannels > 0 && numSpectralChannels <= numChannels);
+        channelData.resize(channelDataSize * numSpectralChannels);
+        for (int c = 0; c < numSpectralChannels; ++c)
+            channelPointers.push_back(channelData.data() + c * channelDataSize);
+
+        if (batchScheduler != nullptr && !splitTransform)
+            acquireBatchSlots(*batchScheduler);
+
+        // Periodic hann: build one extra point and drop it.
+        analysisWindow.resize(fftSize + 1);
+        juce::dsp::WindowingFunction<float>::fillWindowingTables(analysisWindow.data(), analysisWindow.size(),
+                                                                 juce::dsp::WindowingFunction<float>::hann, false);
+        analysisWindow.resize(fftSize);
+
+        computeSynthesisWindow();
+    }
+
+    ~FFTProcessor()
     {
-        fftOrder = order;
-        numBins = fftSize / 2 + 1;
-        windowCorrection = (1.f / (.375f * overlap));
+        releaseBatchSlots();
     }
 
     void reset()
     {
         count = 0;
         pos = 0;
+        samplesProcessed = 0;
+        framePosition = 0;
 
         std::fill(inputFifo.begin(), inputFifo.end(), 0.0f);
         std::fill(outputFifo.begin(), outputFifo.end(), 0.0f);
-        isReady = true;
-        inUse = false;
+        framePending = false;
+        nextSplitStep = 0;
+
+        for (auto& frame : batchedFrames)
+        {
+            collectBatchedFrame(frame);
+            frame.stage = BatchedFrame::Stage::empty;
+        }
+        nextBatchedFrame = 0;
+    }
+
+    /*
+      Reads numSamples from every input channel and writes the same number of delayed,
+      processed samples to every output channel. Input and output may not alias.
+     */
+    template <typename FProcess>
+    void process(const float* const* input, float* const* output, int numSamples, bool bypassed, FProcess process_fn)
+    {
+        for (int start = 0; start < numSamples;)
+        {
+            const auto chunk = juce::jmin(numSamples - start, hopSize - count, fftSize - pos);
+
+            for (int c = 0; c < numChannels; ++c)
+            {
+                const float* in = input[c] + start;
+                float* out = output[c] + start;
+                float* inFifo = inputFifo.data() + pos * stride + c;
+                float* outFifo = outputFifo.data() + pos * stride + c;
+
+                for (int i = 0; i < chunk; ++i)
+                {
+                    inFifo[i * stride] = in[i];
+                    out[i] = outFifo[i * stride];
+                    outFifo[i * stride] = 0.0f;
+                }
+            }
+
+            start += chunk;
+            samplesProcessed += chunk;
+            count += chunk;
+            pos += chunk;
+            if (pos == fftSize)
+                pos = 0;
+
+            if (splitTransform && framePending)
+                runSplitSteps((int) ((juce::int64) count * numSplitSteps / hopSize), process_fn);
+
+            if (count == hopSize)
+            {
+                count = 0;
+               #if KRUSH_INSTRUMENTATION
+                if (performanceCounters != nullptr)
+                    performanceCounters->addHop();
+               #endif
+                processHop(bypassed, process_fn);
+            }
+        }
+    }
+
+    int getFFTSize() const { return fftSize; }
+    int getHopSize() const { return hopSize; }
+    int getNumChannels() const { return numChannels; }
+    int getNumSpectralChannels() const { return numSpectralChannels; }
+    int getLatencyInSamples() const
+    {
+        if (scheduler != nullptr)
+            return fftSize + 2 * hopSize;
+
+        return splitTransform ? fftSize + hopSize : fftSize;
+    }
+
+    bool isBatched() const { return scheduler != nullptr; }
+
+    // Records into or replays from the cache's track for this band; nullptr detaches.
+    // Attach after reset(), before the first sample.
+    void setAnalysisCache(SpectralAnalysisCache* cache, int band)
+    {
+        analysisTrack = nullptr;
+        analysisCursor.reset();
+
+        if (cache == nullptr)
+            return;
+
+        if (cache->isRecording())
+            analysisTrack = &cache->getTrack(band);
+        else
+            analysisCursor = cache->createCursor(band);
+    }
+
+    juce::int64 getSamplesProcessed() const { return samplesProcessed; }
+
+    // The FIFOs, frames and windows, not counting the transforms' own tables.
+    size_t getMemoryFootprint() const
+    {
+        auto floats = inputFifo.capacity() + outputFifo.capacity() + frameData.capacity() + channelData.capacity()
+                      + realPlane.capacity() + imagPlane.capacity() + magnitudePlane.capacity()
+                      + analysisWindow.capacity() + synthesisWindow.capacity();
+        for (const auto& frame : batchedFrames)
+            floats += frame.data.capacity();
+
+        return floats * sizeof(float);
     }
 
-    void handleHopSizeChange(int overlapOrder)
+    // Times the window, transform and spectral stages into the counters; nullptr stops.
+    // Does nothing unless KRUSH_INSTRUMENTATION is set.
+    void setPerformanceCounters(PerformanceCounters* counters) { performanceCounters = counters; }
+
+private:
+    struct BatchedFrame
+    {
+        enum class Stage { empty, bypassed, forward, replayed, inverse };
+
+        std::vector<float> data;
+        std::vector<FFTBatchScheduler::Slot*> slots;
+        std::vector<float*> channels;
+        juce::int64 position = 0;
+        Stage stage = Stage::empty;
+    };
+
+    template <typename FProcess>
+    void processHop(bool bypassed, FProcess& process_fn)
     {
-        overlap = 1 << overlapOrder;
-        windowCorrection = 2.f / 3.f;
+        if (scheduler != nullptr)
+        {
+            processBatchedHop(bypassed, process_fn);
+            return;
+        }
+
+        if (splitTransform)
+        {
+            if (framePending)
+            {
+                interleaveChannels(frameData.data(), channelPointers.data());
+                addFrameToOutput(frameData.data());
+            }
+
+            captureFrame(frameData.data());
+            deinterleaveChannels(frameData.data(), channelPointers.data());
+            framePosition = samplesProcessed;
+            framePending = true;
+            frameBypassed = bypassed;
+            frameReplayed = analysisCursor != nullptr && analysisCursor->hasFrame();
+            nextSplitStep = 0;
+            return;
+        }
+
+        captureFrame(frameData.data());
+        framePosition = samplesProcessed;
+
+        if (!bypassed)
+        {
+            if (!replayAnalysis(channelPointers.data()))
+            {
+                deinterleaveChannels(frameData.data(), channelPointers.data());
+
+                for (int c = 0; c < numSpectralChannels; ++c)
+                    performForwardTransform(channelPointers[c]);
+
+                recordAnalysis(channelPointers.data());
+            }
+
+            runSpectralCallback(channelPointers.data(), process_fn);
+
+            for (int c = 0; c < numSpectralChannels; ++c)
+                performInverseTransform(channelPointers[c]);
+
+            interleaveChannels(frameData.data(), channelPointers.data());
+        }
+
+        addFrameToOutput(frameData.data());
     }
 
+    // The frames alternate between two sets of slots: at each hop the older frame's
+    // inverses come back and go out, then the newer one moves on to its inverses, and the
+    // older set is free again for the frame being captured.
     template <typename FProcess>
-    float processSample(float sample, bool bypassed, FProcess process_fn)
+    void processBatchedHop(bool bypassed, FProcess& process_fn)
+    {
+        auto& oldest = batchedFrames[(size_t) nextBatchedFrame];
+        auto& previous = batchedFrames[(size_t) (1 - nextBatchedFrame)];
+
+        if (oldest.stage == BatchedFrame::Stage::inverse)
+        {
+            {
+                KRUSH_TIME_STAGE(performanceCounters, inverse);
+                collectBatchedFrame(oldest);
+            }
+            interleaveChannels(oldest.data.data(), oldest.channels.data());
+        }
+
+        if (oldest.stage != BatchedFrame::Stage::empty)
+            addFrameToOutput(oldest.data.data());
+
+        if (previous.stage == BatchedFrame::Stage::forward || previous.stage == BatchedFrame::Stage::replayed)
+        {
+            if (previous.stage == BatchedFrame::Stage::forward)
+            {
+                {
+                    KRUSH_TIME_STAGE(performanceCounters, forward);
+                    collectBatchedFrame(previous);
+                }
+                recordAnalysis(previous.channels.data());
+            }
+            else
+            {
+                replayAnalysis(previous.channels.data());
+            }
+
+            framePosition = previous.position;
+            runSpectralCallback(previous.channels.data(), process_fn);
+            submitBatchedFrame(previous, FFTBatchScheduler::Direction::inverse);
+            previous.stage = BatchedFrame::Stage::inverse;
+        }
+
+        captureFrame(oldest.data.data());
+        oldest.position = samplesProcessed;
+        oldest.stage = BatchedFrame::Stage::bypassed;
+
+        if (!bypassed && analysisCursor != nullptr && analysisCursor->hasFrame())
+        {
+            oldest.stage = BatchedFrame::Stage::replayed;
+        }
+        else if (!bypassed)
+        {
+            deinterleaveChannels(oldest.data.data(), oldest.channels.data());
+            submitBatchedFrame(oldest, FFTBatchScheduler::Direction::forward);
+            oldest.stage = BatchedFrame::Stage::forward;
+        }
+
+        nextBatchedFrame = 1 - nextBatchedFrame;
+    }
+
+    void acquireBatchSlots(FFTBatchScheduler& batchScheduler)
+    {
+        scheduler = &batchScheduler;
+
+        for (auto& frame : batchedFrames)
+        {
+            frame.data.resize(fftSize * stride);
+            for (int c = 0; c < numSpectralChannels; ++c)
+            {
+                frame.slots.push_back(scheduler->acquireSlot(fftSize));
+                frame.channels.push_back(frame.slots.back() != nullptr ? frame.slots.back()->getData() : nullptr);
+            }
+        }
+
+        // Out of slots: give back what we got and transform on our own.
+        for (auto& frame : batchedFrames)
+        {
+            if (std::find(frame.slots.begin(), frame.slots.end(), nullptr) != frame.slots.end())
+            {
+                releaseBatchSlots();
+                return;
+            }
+        }
+    }
+
+    void releaseBatchSlots()
     {
-        inputFifo[pos] = sample;
-        float outputSample = outputFifo[pos];
-        outputFifo[pos] = 0.0f;
+        if (scheduler == nullptr)
+            return;
+
+        for (auto& frame : batchedFrames)
+        {
+            for (auto* slot : frame.slots)
+                scheduler->releaseSlot(slot);
 
-        pos += 1;
-        if (pos == fftSize)
-            pos = 0;
+            frame = BatchedFrame();
+        }
+
+        scheduler = nullptr;
+    }
+
+    void submitBatchedFrame(BatchedFrame& frame, FFTBatchScheduler::Direction direction)
+    {
+        for (auto* slot : frame.slots)
+            scheduler->submit(*slot, direction);
+    }
+
+    void collectBatchedFrame(BatchedFrame& frame)
+    {
+        if (frame.stage != BatchedFrame::Stage::forward && frame.stage != BatchedFrame::Stage::inverse)
+            return;
+
+        for (auto* slot : frame.slots)
+            scheduler->complete(*slot);
+    }
+
+    void captureFrame(float* framePtr)
+    {
+        KRUSH_TIME_STAGE(performanceCounters, window);
+        const float *inputPtr = inputFifo.data();
+
+        // Copy the input FIFO into the working frame in two parts.
+        std::memcpy(framePtr, inputPtr + pos * stride, (fftSize - pos) * stride * sizeof(float));
+        if (pos > 0)
+        {
+            std::memcpy(framePtr + (fftSize - pos) * stride, inputPtr, pos * stride * sizeof(float));
+        }
+
+        multiplyByWindow(framePtr, analysisWindow.data());
+    }
+
+    void multiplyByWindow(float* framePtr, const float* window)
+    {
+        constexpr int lanes = SpectralFrame::laneGroupSize;
+
+        for (int i = 0; i < fftSize; ++i)
+        {
+            float* sample = framePtr + i * stride;
+            const auto gain = window[i];
+
+            for (int group = 0; group < stride; group += lanes)
+                for (int l = group; l < group + lanes; ++l)
+                    sample[l] *= gain;
+        }
+    }
+
+    void deinterleaveChannels(const float* framePtr, float* const* channels)
+    {
+        KRUSH_TIME_STAGE(performanceCounters, window);
+        for (int c = 0; c < numSpectralChannels; ++c)
+        {
+            float* data = channels[c];
+            for (int i = 0; i < fftSize; ++i)
+                data[i] = framePtr[i * stride + c];
+        }
+    }
 
-        count += 1;
-        if (count == hopSize)
+    void interleaveChannels(float* framePtr, const float* const* channels)
+    {
+        KRUSH_TIME_STAGE(performanceCounters, window);
+        for (int c = 0; c < numSpectralChannels; ++c)
         {
-            count = 0;
-            const float *inputPtr = inputFifo.data();
-            float *fftPtr = fftData.data();
+            const float* data = channels[c];
+            for (int i = 0; i < fftSize; ++i)
+                framePtr[i * stride + c] = data[i];
+        }
+    }
 
-            // Copy the input FIFO into the FFT working space in two parts.
-            std::memcpy(fftPtr, inputPtr + pos, (fftSize - pos) * sizeof(float));
-            if (pos > 0)
+    void addFrameToOutput(float* framePtr)
+    {
+        KRUSH_TIME_STAGE(performanceCounters, window);
+        float *outputPtr = outputFifo.data();
+
+        // Synthesis window with the overlap-add normalisation folded in.
+        multiplyByWindow(framePtr, synthesisWindow.data());
+
+        // Add the IFFT results to the output FIFO, all channels in one run.
+        const auto wrapped = pos * stride;
+        const auto unwrapped = (fftSize - pos) * stride;
+        juce::FloatVectorOperations::add(outputPtr, framePtr + unwrapped, wrapped);
+        juce::FloatVectorOperations::add(outputPtr + wrapped, framePtr, unwrapped);
+    }
+
+    template <typename FProcess>
+    void runSpectralCallback(float* const* channels, FProcess& process_fn)
+    {
+        KRUSH_TIME_STAGE(performanceCounters, spectral);
+        for (int c = 0; c < numSpectralChannels; ++c)
+        {
+            const float* bins = channels[c];
+            for (int b = 0; b < numBins; ++b)
             {
-                std::memcpy(fftPtr + fftSize - pos, inputPtr, pos * sizeof(float));
+                realPlane[b * spectralStride + c] = bins[b * 2];
+                imagPlane[b * spectralStride + c] = bins[b * 2 + 1];
             }
+        }
 
-            window.multiplyWithWindowingTable(fftPtr, fftSize);
+        SpectralFrame frame;
+        frame.real = realPlane.data();
+        frame.imag = imagPlane.data();
+        frame.magnitude = magnitudePlane.data();
+        frame.numBins = numBins;
+        frame.endBin = numBins;
+        frame.numChannels = numSpectralChannels;
+        frame.stride = spectralStride;
+        frame.samplePosition = framePosition;
+        process_fn(frame);
 
-            if (!bypassed)
+        for (int c = 0; c < numSpectralChannels; ++c)
+        {
+            float* bins = channels[c];
+            for (int b = 0; b < numBins; ++b)
             {
-                fft.performRealOnlyForwardTransform(fftPtr, true);
-                process_fn(reinterpret_cast<std::complex<float> *>(fftPtr));
-                fft.performRealOnlyInverseTransform(fftPtr);
+                bins[b * 2] = realPlane[b * spectralStride + c];
+                bins[b * 2 + 1] = imagPlane[b * spectralStride + c];
             }
+        }
+    }
 
-            window.multiplyWithWindowingTable(fftPtr, fftSize);
+    // Steps are every channel's forward passes, the spectral callback, then every channel's
+    // inverse passes. Channels run one after another so they can share one MixedRadixFFT.
+    template <typename FProcess>
+    void runSplitSteps(int stepsDue, FProcess& process_fn)
+    {
+        if (frameBypassed)
+        {
+            nextSplitStep = numSplitSteps;
+            return;
+        }
 
-            juce::FloatVectorOperations::multiply(fftPtr, windowCorrection, fftSize);
+        const auto numPasses = mixedRadixFFT->getNumPasses();
+        const auto forwardSteps = numPasses * numSpectralChannels;
 
-            // Add the IFFT results to the output FIFO.
-            for (int i = 0; i < pos; ++i)
+        for (; nextSplitStep < stepsDue; ++nextSplitStep)
+        {
+            if (nextSplitStep < forwardSteps)
             {
-                outputFifo[i] += fftData[i + fftSize - pos];
+                KRUSH_TIME_STAGE(performanceCounters, forward);
+                if (!frameReplayed)
+                    mixedRadixFFT->performForwardPass(channelPointers[nextSplitStep / numPasses], nextSplitStep % numPasses);
             }
-            for (int i = 0; i < fftSize - pos; ++i)
+            else if (nextSplitStep == forwardSteps)
             {
-                outputFifo[i + pos] += fftData[i];
+                if (frameReplayed)
+                    replayAnalysis(channelPointers.data());
+                else
+                    recordAnalysis(channelPointers.data());
+
+                runSpectralCallback(channelPointers.data(), process_fn);
+            }
+            else
+            {
+                KRUSH_TIME_STAGE(performanceCounters, inverse);
+                const auto step = nextSplitStep - forwardSteps - 1;
+                mixedRadixFFT->performInversePass(channelPointers[step / numPasses], step % numPasses);
             }
         }
+    }
 
-        return outputSample;
+    // Only the non-negative bins, which is all the spectral callback and the inverses read.
+    bool replayAnalysis(float* const* channels)
+    {
+        return analysisCursor != nullptr && analysisCursor->read(channels, numSpectralChannels, numBins * 2);
     }
-    
-    int getLatencyInSamples() const { return fftSize; }
-    bool isFFTReady() { return isReady;}
-    void prepFFTForReset() { isReady = false; inUse = false;}
-    bool isFFTInUse() { return inUse;}
-    void setFFTInUse(bool use) { inUse = use;}
 
-private:
+    void recordAnalysis(const float* const* channels)
+    {
+        if (analysisTrack != nullptr)
+            analysisTrack->write(channels, numSpectralChannels, numBins * 2);
+    }
+
+    void performForwardTransform(float* data)
+    {
+        KRUSH_TIME_STAGE(performanceCounters, forward);
+        if (fft != nullptr)
+            fft->performRealOnlyForwardTransform(data, true);
+        else
+            mixedRadixFFT->performRealOnlyForwardTransform(data, true);
+    }
 
-    bool isReady = true;
-    bool inUse = false;
-    int fftOrder, fftSize, overlap, hopSize, numBins;
+    void performInverseTransform(float* data)
+    {
+        KRUSH_TIME_STAGE(performanceCounters, inverse);
+        if (fft != nullptr)
+            fft->performRealOnlyInverseTransform(data);
+        else
+            mixedRadixFFT->performRealOnlyInverseTransform(data);
+    }
+
+    void computeSynthesisWindow()
+    {
+        // The squared windows summed at every hop offset give the overlap-add gain for that
+        // offset. Dividing it out per offset keeps the output exact for any size/hop pair,
+        // including hops that don't divide the window evenly.
+        std::vector<float> colaGain(hopSize, 0.0f);
+        for (int i = 0; i < fftSize; ++i)
+            colaGain[i % hopSize] += analysisWindow[i] * analysisWindow[i];
+
+        synthesisWindow.resize(fftSize);
+        for (int i = 0; i < fftSize; ++i)
+            synthesisWindow[i] = analysisWindow[i] / colaGain[i % hopSize];
+    }
+
+    int fftSize, overlap, hopSize, numBins;
+    int numChannels, stride;
+    int numSpectralChannels, spectralStride;
+    int channelDataSize = 0;
     int count = 0;
     int pos = 0;
-    float windowCorrection{1};
-    
-    juce::dsp::FFT fft;
-    juce::dsp::WindowingFunction<float> window;
-    
+    juce::int64 samplesProcessed = 0;
+    juce::int64 framePosition = 0;
+
+    bool splitTransform;
+    bool framePending = false;
+    bool frameBypassed = false;
+    bool frameReplayed = false;
+    int numSplitSteps = 0;
+    int nextSplitStep = 0;
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::unique_ptr<MixedRadixFFT> mixedRadixFFT;
+
+    FFTBatchScheduler* scheduler = nullptr;
+    std::array<BatchedFrame, 2> batchedFrames;
+    int nextBatchedFrame = 0;
+
+    SpectralAnalysisCache::Track* analysisTrack = nullptr;
+    std::unique_ptr<SpectralAnalysisCache::Cursor> analysisCursor;
+
+    PerformanceCounters* performanceCounters = nullptr;
+
     std::vector<float> inputFifo;
     std::vector<float> outputFifo;
-    std::vector<float> fftData; 
+    std::vector<float> frameData;
+    std::vector<float> channelData;
+    std::vector<float*> channelPointers;
+    std::vector<float> realPlane, imagPlane, magnitudePlane;
+    std::vector<float> analysisWindow;
+    std::vector<float> synthesisWindow;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FFTProcessor)
 };
\ No newline at end of file
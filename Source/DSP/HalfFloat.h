@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+/*
+  16-bit floats for storage that only needs about three significant digits, like
+  SpectralFreeze's frame history. Only non-negative values are handled: anything under the
+  smallest normal half (6.1e-5) is stored as zero and anything over the largest (65504)
+  clamps to it. Round-tripping a value that was already a half gives it back exactly.
+ */
+namespace HalfFloat
+{
+    inline uint16_t fromFloat(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        constexpr uint32_t rebias = (127 - 15) << 23;
+        constexpr uint32_t smallestNormal = rebias + (1 << 23);
+        constexpr uint32_t largest = 0x7bff;
+
+        if (value <= 0.0f || bits < smallestNormal)
+            return 0;
+
+        // Drop the 13 extra mantissa bits, rounding to nearest; a carry rolls into the exponent.
+        const auto half = (bits - rebias + (1 << 12)) >> 13;
+        return (uint16_t) (half > largest ? largest : half);
+    }
+
+    inline float toFloat(uint16_t half)
+    {
+        if (half == 0)
+            return 0.0f;
+
+        const uint32_t bits = ((uint32_t) half << 13) + ((127 - 15) << 23);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // Every half is a whole number of the smallest step, 2^-24, so sums of them can be
+    // kept exactly in integers of it: even 65504 is under 2^40 steps.
+    constexpr double stepSize = 1.0 / (1 << 24);
+
+    inline int64_t toSteps(uint16_t half)
+    {
+        if (half == 0)
+            return 0;
+
+        return (int64_t) (1024 + (half & 0x3ff)) << ((half >> 10) - 1);
+    }
+}
@@ -0,0 +1,295 @@
+#pragma once
+#include "juce_core/juce_core.h"
+#include <cmath>
+#include <complex>
+#include <algorithm>
+#include <vector>
+
+/*
+  Real-only FFT for any even size whose factors are 2, 3 and 5 (1536, 2400, 6000...).
+  It uses the same in-place layout as juce::dsp::FFT's real-only transforms, so
+  FFTProcessor can swap between the two without touching the spectral code:
+    - forward: `size` real samples in, size / 2 + 1 interleaved complex bins out
+    - inverse: size / 2 + 1 bins in, `size` real samples out, scaled by 1 / size
+  The data buffer must hold 2 * size floats, as with juce::dsp::FFT.
+
+  Internally the real signal is packed into a complex signal of half the length and
+  run through a Stockham autosort FFT built from radix 4, 2, 3 and 5 passes.
+ */
+class MixedRadixFFT
+{
+public:
+    using Complex = std::complex<float>;
+
+    explicit MixedRadixFFT(int size)
+        : fftSize(size), halfSize(size / 2), bufferA((size_t) size / 2), bufferB((size_t) size / 2),
+          realTwiddles((size_t) size / 2 + 1)
+    {
+        jassert(isSupportedSize(size));
+
+        // Radix 4 first, then 2, gives better accuracy and speed than leading with the odd radices.
+        auto remaining = halfSize;
+        for (auto radix : {4, 2, 3, 5})
+        {
+            while (remaining % radix == 0)
+            {
+                stages.push_back({radix, 0, 0, 0});
+                remaining /= radix;
+            }
+        }
+
+        auto length = halfSize;
+        auto stride = 1;
+        for (auto& stage : stages)
+        {
+            stage.length = length;
+            stage.stride = stride;
+            stage.twiddleOffset = (int) twiddles.size();
+
+            const auto subLength = length / stage.radix;
+            for (int p = 0; p < subLength; ++p)
+                for (int k = 1; k < stage.radix; ++k)
+                    twiddles.push_back(std::polar(1.0f, (float) (-2.0 * pi * p * k / length)));
+
+            length = subLength;
+            stride *= stage.radix;
+        }
+
+        for (int k = 0; k <= halfSize; ++k)
+            realTwiddles[(size_t) k] = std::polar(1.0f, (float) (-2.0 * pi * k / fftSize));
+    }
+
+    static bool isSupportedSize(int size)
+    {
+        if (size < 4 || size % 2 != 0)
+            return false;
+
+        for (auto radix : {2, 3, 5})
+            while (size % radix == 0)
+                size /= radix;
+
+        return size == 1;
+    }
+
+    int getSize() const { return fftSize; }
+
+    void performRealOnlyForwardTransform(float* data, bool onlyCalculateNonNegativeFrequencies = false)
+    {
+        for (int pass = 0; pass < getNumPasses(); ++pass)
+            performForwardPass(data, pass);
+
+        if (!onlyCalculateNonNegativeFrequencies)
+        {
+            auto* bins = reinterpret_cast<Complex*>(data);
+            for (int k = halfSize + 1; k < fftSize; ++k)
+                bins[k] = std::conj(bins[fftSize - k]);
+        }
+    }
+
+    void performRealOnlyInverseTransform(float* data)
+    {
+        for (int pass = 0; pass < getNumPasses(); ++pass)
+            performInversePass(data, pass);
+    }
+
+    /*
+      The transforms can also be run one pass at a time, so a caller can spread a large
+      transform over several audio callbacks. Passes must be run in order, 0 to
+      getNumPasses() - 1, on the same data pointer and without interleaving a forward and
+      an inverse transform.
+     */
+    int getNumPasses() const { return (int) stages.size() + 1; }
+
+    void performForwardPass(float* data, int pass)
+    {
+        if (pass == 0)
+            std::copy(data, data + fftSize, reinterpret_cast<float*>(bufferA.data()));
+
+        if (pass < (int) stages.size())
+        {
+            runStage<false>(pass);
+            return;
+        }
+
+        const auto* z = resultBuffer();
+        auto* bins = reinterpret_cast<Complex*>(data);
+
+        bins[0] = {z[0].real() + z[0].imag(), 0.0f};
+        bins[halfSize] = {z[0].real() - z[0].imag(), 0.0f};
+
+        for (int k = 1; k <= halfSize / 2; ++k)
+        {
+            const auto a = z[k];
+            const auto b = std::conj(z[halfSize - k]);
+            const auto even = 0.5f * (a + b);
+            const auto odd = Complex(0.0f, -0.5f) * (a - b);
+
+            bins[k] = even + realTwiddles[(size_t) k] * odd;
+            bins[halfSize - k] = std::conj(even - realTwiddles[(size_t) k] * odd);
+        }
+    }
+
+    void performInversePass(float* data, int pass)
+    {
+        if (pass == 0)
+        {
+            const auto* bins = reinterpret_cast<const Complex*>(data);
+            auto* z = bufferA.data();
+
+            for (int k = 0; k <= halfSize / 2; ++k)
+            {
+                const auto a = bins[k];
+                const auto b = std::conj(bins[halfSize - k]);
+                const auto even = 0.5f * (a + b);
+                const auto odd = Complex(0.0f, 0.5f) * std::conj(realTwiddles[(size_t) k]) * (a - b);
+
+                z[k] = even + odd;
+                if (k != 0 && k != halfSize - k)
+                    z[halfSize - k] = std::conj(even - odd);
+            }
+            return;
+        }
+
+        runStage<true>(pass - 1);
+
+        if (pass == (int) stages.size())
+        {
+            const auto* z = reinterpret_cast<const float*>(resultBuffer());
+            const auto scale = 1.0f / (float) halfSize;
+            for (int i = 0; i < fftSize; ++i)
+                data[i] = z[i] * scale;
+        }
+    }
+
+    // The plan and the butterflies, shared with BatchedFFT so both run the same arithmetic.
+    struct Stage
+    {
+        int radix, length, stride, twiddleOffset;
+    };
+
+    const std::vector<Stage>& getStages() const { return stages; }
+    const std::vector<Complex>& getTwiddles() const { return twiddles; }
+    const std::vector<Complex>& getRealTwiddles() const { return realTwiddles; }
+
+    // Multiplies by -i for the forward transform, +i for the inverse.
+    template <typename ComplexType>
+    static ComplexType rotate(ComplexType c, bool inverse)
+    {
+        return inverse ? ComplexType(-c.imag(), c.real()) : ComplexType(c.imag(), -c.real());
+    }
+
+    // Generic over the complex type so BatchedFFT can run it on a whole lane group at once.
+    template <int radix, bool inverse, typename ComplexType>
+    static void butterfly(const ComplexType* a, ComplexType* b)
+    {
+        if constexpr (radix == 2)
+        {
+            b[0] = a[0] + a[1];
+            b[1] = a[0] - a[1];
+        }
+        else if constexpr (radix == 4)
+        {
+            const auto t0 = a[0] + a[2];
+            const auto t1 = a[0] - a[2];
+            const auto t2 = a[1] + a[3];
+            const auto t3 = rotate(a[1] - a[3], inverse);
+
+            b[0] = t0 + t2;
+            b[1] = t1 + t3;
+            b[2] = t0 - t2;
+            b[3] = t1 - t3;
+        }
+        else if constexpr (radix == 3)
+        {
+            constexpr float sin60 = 0.86602540378443864676f;
+
+            const auto t1 = a[1] + a[2];
+            const auto t2 = a[0] - 0.5f * t1;
+            const auto t3 = sin60 * rotate(a[1] - a[2], inverse);
+
+            b[0] = a[0] + t1;
+            b[1] = t2 + t3;
+            b[2] = t2 - t3;
+        }
+        else if constexpr (radix == 5)
+        {
+            constexpr float c1 = 0.30901699437494742410f, c2 = -0.80901699437494742410f;
+            constexpr float s1 = 0.95105651629515357212f, s2 = 0.58778525229247312917f;
+
+            const auto sum1 = a[1] + a[4], sum2 = a[2] + a[3];
+            const auto diff1 = a[1] - a[4], diff2 = a[2] - a[3];
+
+            const auto r1 = a[0] + c1 * sum1 + c2 * sum2;
+            const auto r2 = a[0] + c2 * sum1 + c1 * sum2;
+            const auto i1 = rotate(s1 * diff1 + s2 * diff2, inverse);
+            const auto i2 = rotate(s2 * diff1 - s1 * diff2, inverse);
+
+            b[0] = a[0] + sum1 + sum2;
+            b[1] = r1 + i1;
+            b[4] = r1 - i1;
+            b[2] = r2 + i2;
+            b[3] = r2 - i2;
+        }
+    }
+
+private:
+    static constexpr double pi = 3.14159265358979323846;
+
+    const Complex* resultBuffer() const
+    {
+        return stages.size() % 2 == 0 ? bufferA.data() : bufferB.data();
+    }
+
+    template <bool inverse>
+    void runStage(int index)
+    {
+        const auto& stage = stages[(size_t) index];
+        const auto* x = index % 2 == 0 ? bufferA.data() : bufferB.data();
+        auto* y = index % 2 == 0 ? bufferB.data() : bufferA.data();
+
+        switch (stage.radix)
+        {
+            case 4: butterflies<4, inverse>(stage, x, y); break;
+            case 2: butterflies<2, inverse>(stage, x, y); break;
+            case 3: butterflies<3, inverse>(stage, x, y); break;
+            case 5: butterflies<5, inverse>(stage, x, y); break;
+            default: jassertfalse; break;
+        }
+    }
+
+    template <int radix, bool inverse>
+    void butterflies(const Stage& stage, const Complex* x, Complex* y) const
+    {
+        const auto m = stage.length / radix;
+        const auto s = stage.stride;
+        const auto* w = twiddles.data() + stage.twiddleOffset;
+
+        for (int p = 0; p < m; ++p)
+        {
+            Complex tw[radix];
+            tw[0] = {1.0f, 0.0f};
+            for (int k = 1; k < radix; ++k)
+                tw[k] = inverse ? std::conj(w[p * (radix - 1) + k - 1]) : w[p * (radix - 1) + k - 1];
+
+            for (int q = 0; q < s; ++q)
+            {
+                Complex a[radix], b[radix];
+                for (int j = 0; j < radix; ++j)
+                    a[j] = x[q + s * (p + j * m)];
+
+                butterfly<radix, inverse>(a, b);
+
+                for (int k = 0; k < radix; ++k)
+                    y[q + s * (radix * p + k)] = b[k] * tw[k];
+            }
+        }
+    }
+
+    int fftSize, halfSize;
+    std::vector<Stage> stages;
+    std::vector<Complex> twiddles;
+    std::vector<Complex> bufferA, bufferB;
+    std::vector<Complex> realTwiddles;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MixedRadixFFT)
+};
@@ -0,0 +1,174 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include <memory>
+#include <vector>
+
+/*
+  Forward spectra kept from one offline render, so that later renders of the same input
+  with the same analysis settings can skip the windowing and forward transforms. Only
+  what comes before the spectral callback is cached; the chain, the inverse transforms
+  and everything after them still run, so a replayed render comes out exactly as a
+  normal one would.
+
+  One render records: each engine band gets a track, and every frame it transforms goes
+  into the track in order as its non-negative bins. After finishRecording() the cache is
+  read only, and any number of renders can replay it at once through their own cursors.
+
+  Frames are kept in memory up to a byte budget shared by all the tracks. Past that,
+  each track carries on in a temporary file that is written and read back sequentially.
+ */
+class SpectralAnalysisCache
+{
+public:
+    static constexpr size_t defaultMemoryBudget = (size_t) 1 << 30;
+
+    class Track
+    {
+    public:
+        explicit Track(SpectralAnalysisCache& owner) : cache(owner) {}
+
+        void write(const float* const* channels, int numChannels, int channelSize)
+        {
+            const auto bytes = (size_t) (numChannels * channelSize) * sizeof(float);
+
+            if (spillStream == nullptr && cache.reserve(bytes))
+            {
+                auto& frame = frames.emplace_back((size_t) (numChannels * channelSize));
+                for (int c = 0; c < numChannels; ++c)
+                    std::copy(channels[c], channels[c] + channelSize, frame.begin() + c * channelSize);
+            }
+            else
+            {
+                if (spillStream == nullptr)
+                {
+                    spillFile = std::make_unique<juce::TemporaryFile>(".krushcache");
+                    spillStream = std::make_unique<juce::FileOutputStream>(spillFile->getFile());
+                    failed = failed || !spillStream->openedOk();
+                }
+
+                for (int c = 0; c < numChannels && !failed; ++c)
+                    failed = !spillStream->write(channels[c], (size_t) channelSize * sizeof(float));
+            }
+
+            ++numFrames;
+        }
+
+    private:
+        friend class SpectralAnalysisCache;
+
+        SpectralAnalysisCache& cache;
+        std::vector<std::vector<float>> frames;
+        std::unique_ptr<juce::TemporaryFile> spillFile;
+        std::unique_ptr<juce::FileOutputStream> spillStream;
+        juce::int64 numFrames = 0;
+        bool failed = false;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Track)
+    };
+
+    // A replaying band's read position in its track.
+    class Cursor
+    {
+    public:
+        explicit Cursor(const Track& trackToRead) : track(trackToRead) {}
+
+        bool hasFrame() const { return next < track.numFrames; }
+
+        bool read(float* const* channels, int numChannels, int channelSize)
+        {
+            if (!hasFrame())
+                return false;
+
+            if (next < (juce::int64) track.frames.size())
+            {
+                const auto& frame = track.frames[(size_t) next];
+                for (int c = 0; c < numChannels; ++c)
+                    std::copy(frame.begin() + c * channelSize, frame.begin() + (c + 1) * channelSize, channels[c]);
+            }
+            else
+            {
+                if (spillInput == nullptr)
+                    spillInput = std::make_unique<juce::FileInputStream>(track.spillFile->getFile());
+
+                const auto bytes = (int) ((size_t) channelSize * sizeof(float));
+                for (int c = 0; c < numChannels; ++c)
+                    if (spillInput->read(channels[c], bytes) != bytes)
+                        return false;
+            }
+
+            ++next;
+            return true;
+        }
+
+    private:
+        const Track& track;
+        juce::int64 next = 0;
+        std::unique_ptr<juce::FileInputStream> spillInput;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Cursor)
+    };
+
+    explicit SpectralAnalysisCache(size_t memoryBudgetBytes = defaultMemoryBudget)
+        : memoryBudget(memoryBudgetBytes)
+    {
+    }
+
+    bool isRecording() const { return recording; }
+
+    // While recording, the track for a band, created the first time it's asked for.
+    Track& getTrack(int band)
+    {
+        jassert(recording);
+        while ((int) tracks.size() <= band)
+            tracks.push_back(std::make_unique<Track>(*this));
+
+        return *tracks[(size_t) band];
+    }
+
+    // After recording, a new read position at the start of a band's track.
+    std::unique_ptr<Cursor> createCursor(int band) const
+    {
+        jassert(!recording);
+        if (!juce::isPositiveAndBelow(band, (int) tracks.size()))
+            return nullptr;
+
+        return std::make_unique<Cursor>(*tracks[(size_t) band]);
+    }
+
+    juce::Result finishRecording()
+    {
+        recording = false;
+
+        for (auto& track : tracks)
+        {
+            if (track->spillStream != nullptr)
+            {
+                track->spillStream->flush();
+                track->failed = track->failed || track->spillStream->getStatus().failed();
+                track->spillStream.reset();
+            }
+
+            if (track->failed)
+                return juce::Result::fail("Can't write the analysis cache");
+        }
+
+        return juce::Result::ok();
+    }
+
+private:
+    bool reserve(size_t bytes)
+    {
+        if (bytesInMemory + bytes > memoryBudget)
+            return false;
+
+        bytesInMemory += bytes;
+        return true;
+    }
+
+    size_t memoryBudget;
+    size_t bytesInMemory = 0;
+    bool recording = true;
+    std::vector<std::unique_ptr<Track>> tracks;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectralAnalysisCache)
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include "SpectralModule.h"
+
+/*
+  Smears magnitudes across frequency with a one-pole filter run up and then back down
+  the bins, so the blur is symmetric and leaves phases alone. The pole is set per band so
+  a given amount spreads over the same bandwidth in Hz whatever the window size.
+ */
+class SpectralBlur : public SpectralModule
+{
+public:
+    // Spread at full blur, in bins of a 1024 point window.
+    static constexpr double maxSpreadBins = 8.0;
+
+    void prepare(const SpectralModuleSpec& spec) override
+    {
+        stride = spec.getStride();
+        bandSizes = spec.bandSizes;
+        coefficients.assign(bandSizes.size(), 0.0f);
+
+        int maxBins = 0;
+        for (int b = 0; b < spec.getNumBands(); ++b)
+            maxBins = juce::jmax(maxBins, spec.getNumBins(b));
+        smoothed.resize((size_t) (maxBins * stride));
+
+        amount = -1.0f;
+        setAmount(0.0f);
+    }
+
+    void setAmount(float newAmount)
+    {
+        if (newAmount == amount)
+            return;
+
+        amount = newAmount;
+        for (size_t b = 0; b < bandSizes.size(); ++b)
+        {
+            const auto spread = amount * maxSpreadBins * bandSizes[b] / 1024.0;
+            coefficients[b] = spread > 0.0 ? (float) std::exp(-1.0 / spread) : 0.0f;
+        }
+    }
+
+    bool isActive() const override { return amount > 0.0f; }
+
+    size_t getMemoryFootprint() const override
+    {
+        return (coefficients.capacity() + smoothed.capacity()) * sizeof(float) + bandSizes.capacity() * sizeof(int);
+    }
+
+    void process(SpectralFrame& frame) override
+    {
+        const auto a = coefficients[(size_t) frame.band];
+        const auto firstValue = frame.firstBin * stride;
+        const auto numValues = (frame.endBin - frame.firstBin) * stride;
+        float* re = frame.real + firstValue;
+        float* im = frame.imag + firstValue;
+        float* mag = frame.magnitude + firstValue;
+        float* smooth = smoothed.data();
+
+        for (int i = 0; i < numValues; ++i)
+            mag[i] = getMagnitude(re[i], im[i]);
+
+        for (int c = 0; c < stride; ++c)
+            smooth[c] = mag[c];
+        for (int i = stride; i < numValues; ++i)
+            smooth[i] = mag[i] + a * (smooth[i - stride] - mag[i]);
+
+        for (int i = numValues - 2 * stride; i >= 0; --i)
+            smooth[i] += a * (smooth[i + stride] - smooth[i]);
+
+        for (int i = 0; i < numValues; ++i)
+            setMagnitude(re[i], im[i], mag[i], smooth[i]);
+    }
+
+private:
+    std::vector<int> bandSizes;
+    std::vector<float> coefficients;
+    std::vector<float> smoothed;
+    int stride = 0;
+    float amount = 0.0f;
+};
@@ -0,0 +1,141 @@
+#pragma once
+#include <array>
+#include "SpectralBlur.h"
+#include "SpectralCrush.h"
+#include "SpectralFreeze.h"
+#include "SpectralGate.h"
+#include "SpectralTilt.h"
+
+/*
+  The spectral effects, run in a fixed order on each frame the engine hands out:
+  freeze, blur, gate, crush, tilt. The modules are members, so the whole chain is
+  allocated along with the engine that owns it, and inactive modules cost nothing.
+
+  The chain can be limited to a frequency range. Each band's range is turned into bins
+  when it's set, and the modules only walk those bins.
+ */
+class SpectralChain
+{
+public:
+    // Everything that can be set while running, for setParameter().
+    enum class Parameter { crush, grouping, freeze, smear, blur, gate, tilt, lowLimit, highLimit };
+
+    static constexpr float minFrequency = 20.0f;
+    static constexpr float maxFrequency = 20000.0f;
+
+    void prepare(const SpectralModuleSpec& spec)
+    {
+        for (auto* module : modules)
+            module->prepare(spec);
+
+        bandSizes = spec.bandSizes;
+        sampleRate = spec.sampleRate;
+        binRanges.resize(bandSizes.size());
+
+        lowFrequency = highFrequency = -1.0f;
+        setFrequencyRange(minFrequency, maxFrequency);
+    }
+
+    // The ends of the parameter ranges mean no limit: minFrequency takes in DC, and
+    // maxFrequency everything up to Nyquist.
+    void setFrequencyRange(float low, float high)
+    {
+        if (low == lowFrequency && high == highFrequency)
+            return;
+
+        lowFrequency = low;
+        highFrequency = high;
+        anyBinsInRange = false;
+
+        for (size_t b = 0; b < bandSizes.size(); ++b)
+        {
+            const auto numBins = bandSizes[b] / 2 + 1;
+            const auto binWidth = sampleRate / bandSizes[b];
+            auto& range = binRanges[b];
+
+            range.first = low <= minFrequency ? 0 : juce::jmin(numBins, (int) std::ceil(low / binWidth));
+            range.end = high >= maxFrequency ? numBins : juce::jlimit(0, numBins, (int) std::floor(high / binWidth) + 1);
+            anyBinsInRange = anyBinsInRange || range.end > range.first;
+        }
+    }
+
+    void setParameter(Parameter parameter, float value)
+    {
+        switch (parameter)
+        {
+            case Parameter::crush: crush.setCrush(juce::roundToInt(value)); break;
+            case Parameter::grouping: crush.setGrouping(static_cast<SpectralCrush::Grouping>(juce::roundToInt(value))); break;
+            case Parameter::freeze: freeze.setFrozen(value >= 0.5f); break;
+            case Parameter::smear: freeze.setSmear(value); break;
+            case Parameter::blur: blur.setAmount(value); break;
+            case Parameter::gate: gate.setThreshold(value); break;
+            case Parameter::tilt: tilt.setTilt(value); break;
+            case Parameter::lowLimit: setFrequencyRange(value, highFrequency); break;
+            case Parameter::highLimit: setFrequencyRange(lowFrequency, value); break;
+        }
+    }
+
+    // When this is false the engine can skip the transforms altogether.
+    bool hasBinsInRange() const { return anyBinsInRange; }
+
+    // Only freeze and smear carry anything from one frame to the next.
+    bool isFrameLocal() const { return !freeze.isActive(); }
+
+    void reset()
+    {
+        for (auto* module : modules)
+            module->reset();
+    }
+
+    void process(SpectralFrame& frame)
+    {
+        const auto& range = binRanges[(size_t) frame.band];
+        if (range.end <= range.first)
+            return;
+
+        frame.firstBin = range.first;
+        frame.endBin = range.end;
+
+        for (auto* module : modules)
+            if (module->isActive())
+                module->process(frame);
+    }
+
+    size_t getMemoryFootprint() const
+    {
+        size_t bytes = 0;
+        for (const auto* module : modules)
+            bytes += module->getMemoryFootprint();
+
+        return bytes;
+    }
+
+    SpectralFreeze& getFreeze() { return freeze; }
+    SpectralBlur& getBlur() { return blur; }
+    SpectralGate& getGate() { return gate; }
+    SpectralCrush& getCrush() { return crush; }
+    SpectralTilt& getTilt() { return tilt; }
+
+private:
+    struct BinRange
+    {
+        int first = 0;
+        int end = 0;
+    };
+
+    std::vector<int> bandSizes;
+    std::vector<BinRange> binRanges;
+    double sampleRate = 44100.0;
+    float lowFrequency = minFrequency, highFrequency = maxFrequency;
+    bool anyBinsInRange = true;
+
+    SpectralFreeze freeze;
+    SpectralBlur blur;
+    SpectralGate gate;
+    SpectralCrush crush;
+    SpectralTilt tilt;
+
+    std::array<SpectralModule*, 5> modules{&freeze, &blur, &gate, &crush, &tilt};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectralChain)
+};
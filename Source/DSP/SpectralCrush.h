@@ -0,0 +1,170 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include "SpectralModule.h"
+
+/*
+  The Krush kernel: quantises every bin's magnitude to 16 bits, and above a crush of 1
+  copies the magnitude of the first bin in each group onto the rest of the group. Phases
+  are kept. Runs across all channels of a bin at once.
+
+  Groups are `crush` bins wide in linear grouping. Log and Bark grouping widen them with
+  frequency instead, to a fixed fraction of an octave or of a Bark, so the bass keeps its
+  detail and the highs are crushed harder; there a bin that is already wider than its
+  group stays on its own.
+
+  The group boundaries for every grouping and crush are worked out per band in prepare(),
+  so the kernel just walks a table of group starts. When the frame's bin range cuts a
+  group, the group's first bin inside the range leads what's left of it.
+ */
+class SpectralCrush : public SpectralModule
+{
+public:
+    static constexpr int maxCrush = 25;
+    enum class Grouping { linear, log, bark };
+
+    void prepare(const SpectralModuleSpec& spec) override
+    {
+        bands.resize((size_t) spec.getNumBands());
+
+        for (int b = 0; b < spec.getNumBands(); ++b)
+        {
+            auto& band = bands[(size_t) b];
+            const auto numBins = spec.getNumBins(b);
+            const auto binWidth = spec.sampleRate / spec.bandSizes[(size_t) b];
+            band.groupStarts.clear();
+
+            for (auto grouping : {Grouping::linear, Grouping::log, Grouping::bark})
+            {
+                for (int crushValue = 1; crushValue <= maxCrush; ++crushValue)
+                {
+                    auto& table = band.tables[(size_t) grouping][(size_t) crushValue - 1];
+                    table.offset = (int) band.groupStarts.size();
+                    addGroupStarts(band.groupStarts, grouping, crushValue, numBins, binWidth);
+                    table.numGroups = (int) band.groupStarts.size() - table.offset;
+
+                    // The end of the last group.
+                    band.groupStarts.push_back(numBins);
+                }
+            }
+        }
+    }
+
+    void setCrush(int newCrush) { crush = juce::jlimit(1, maxCrush, newCrush); }
+    void setGrouping(Grouping newGrouping) { grouping = newGrouping; }
+
+    // Mostly the group tables, which cover every grouping and crush.
+    size_t getMemoryFootprint() const override
+    {
+        auto bytes = bands.capacity() * sizeof(Band);
+        for (const auto& band : bands)
+            bytes += band.groupStarts.capacity() * sizeof(int);
+
+        return bytes;
+    }
+
+    void process(SpectralFrame& frame) override
+    {
+        const auto& band = bands[(size_t) frame.band];
+        const auto& table = band.tables[(size_t) grouping][(size_t) crush - 1];
+        crushFrame(frame, band.groupStarts.data() + table.offset, table.numGroups);
+    }
+
+    // groupStarts holds numGroups + 1 entries, the last being the end of the final group.
+    static void crushFrame(SpectralFrame& frame, const int* groupStarts, int numGroups)
+    {
+        constexpr float crusher = 65536.0f;
+        constexpr int lanes = SpectralFrame::laneGroupSize;
+        const auto stride = frame.stride;
+        float* leaderMagnitude = frame.magnitude;
+
+        const auto firstGroup = (int) (std::upper_bound(groupStarts, groupStarts + numGroups, frame.firstBin) - groupStarts) - 1;
+
+        for (int g = firstGroup; g < numGroups && groupStarts[g] < frame.endBin; ++g)
+        {
+            const auto start = juce::jmax(groupStarts[g], frame.firstBin);
+            const auto end = juce::jmin(groupStarts[g + 1], frame.endBin);
+
+            // The DC bin is left alone, but it still leads its group.
+            for (int group = 0; group < stride; group += lanes)
+            {
+                for (int l = group; l < group + lanes; ++l)
+                {
+                    const auto i = start * stride + l;
+                    const auto magnitude = getMagnitude(frame.real[i], frame.imag[i]);
+
+                    if (start == 0)
+                    {
+                        leaderMagnitude[l] = magnitude;
+                    }
+                    else
+                    {
+                        leaderMagnitude[l] = std::floor(crusher * magnitude) / crusher;
+                        setMagnitude(frame.real[i], frame.imag[i], magnitude, leaderMagnitude[l]);
+                    }
+                }
+            }
+
+            for (int bin = start + 1; bin < end; ++bin)
+            {
+                float* re = frame.real + bin * stride;
+                float* im = frame.imag + bin * stride;
+
+                for (int group = 0; group < stride; group += lanes)
+                    for (int l = group; l < group + lanes; ++l)
+                        setMagnitude(re[l], im[l], getMagnitude(re[l], im[l]), leaderMagnitude[l]);
+            }
+        }
+    }
+
+private:
+    struct GroupTable
+    {
+        int offset = 0;
+        int numGroups = 0;
+    };
+
+    struct Band
+    {
+        std::vector<int> groupStarts;
+        std::array<std::array<GroupTable, maxCrush>, 3> tables;
+    };
+
+    static void addGroupStarts(std::vector<int>& starts, Grouping grouping, int crushValue, int numBins, double binWidth)
+    {
+        if (grouping == Grouping::linear || crushValue == 1)
+        {
+            for (int bin = 0; bin < numBins; bin += crushValue)
+                starts.push_back(bin);
+            return;
+        }
+
+        // Log groups run from 48 per octave at a crush of 2 down to 2 per octave at 25;
+        // Bark groups from an eighth of a Bark to three.
+        const auto width = (double) (crushValue - 1);
+        auto groupIndex = [grouping, width](double frequency)
+        {
+            if (grouping == Grouping::log)
+                return std::floor(std::log2(frequency / 20.0) * 48.0 / width);
+
+            const auto bark = 26.81 * frequency / (1960.0 + frequency) - 0.53;
+            return std::floor(bark * 8.0 / width);
+        };
+
+        // DC has no place on either scale, so it is a group of its own.
+        starts.push_back(0);
+        auto previous = 0.0;
+        for (int bin = 1; bin < numBins; ++bin)
+        {
+            const auto index = groupIndex(bin * binWidth);
+            if (bin == 1 || index != previous)
+                starts.push_back(bin);
+            previous = index;
+        }
+    }
+
+    std::vector<Band> bands;
+    int crush = 1;
+    Grouping grouping = Grouping::linear;
+};
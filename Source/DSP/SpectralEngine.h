@@ -0,0 +1,558 @@
+#pragma once
+#include <array>
+#include <numeric>
+#include <optional>
+#include "FFTProcessor.h"
+#include "SpectralChain.h"
+
+/*
+  Everything the processor needs to build a SpectralEngine. Two engines with equal configs
+  are interchangeable, which is how the processor decides whether it has to rebuild.
+ */
+struct SpectralEngineConfig
+{
+    enum class Mode { single, multiResolution, transientAdaptive };
+
+    int fftSize = 1024;
+    // Every band hops by its size over 2^overlapOrder.
+    int overlapOrder = 2;
+    int numChannels = 2;
+    int numSpectralChannels = 2;
+    Mode mode = Mode::single;
+    double sampleRate = 44100.0;
+    bool batched = false;
+
+    bool operator==(const SpectralEngineConfig& other) const
+    {
+        return fftSize == other.fftSize && overlapOrder == other.overlapOrder && numChannels == other.numChannels
+            && numSpectralChannels == other.numSpectralChannels
+            && mode == other.mode && sampleRate == other.sampleRate && batched == other.batched;
+    }
+
+    bool operator!=(const SpectralEngineConfig& other) const { return !(*this == other); }
+};
+
+/*
+  Runs the whole signal through one FFTProcessor per band and sums the bands.
+
+  In single resolution there is one band at fftSize and this is a thin wrapper. In multi
+  resolution the lows keep fftSize while the mids and highs run at a quarter and a
+  sixteenth of it (never below minBandSize), which keeps bass resolution without smearing
+  the top end.
+
+  The crossover happens in the spectral domain: each band multiplies its spectra by a mask
+  after process_fn, and the masks are raised cosines over two octaves around each crossover
+  that sum to one. That makes it linear phase, so after the smaller bands are delayed up
+  to the low band's latency the bands add back to a delay of the input, as long as every
+  band's mask is smooth over its own bins. A mask that changes within a few bins acts on
+  far more of the frame than the window leaves room for, and the bands then only sum to
+  about -25 dB. From minMultiResolutionSize up (scaled up with the rate past 48 kHz) the
+  transitions span dozens of bins even in the sixteenth band, and the bands null to better
+  than -60 dB; below that, multi resolution runs as a single band, the same as single
+  resolution.
+
+  In transient adaptive mode the long window always runs, and a second processor at an
+  eighth of the size runs on the input delayed so that both come out at the long latency.
+  The long frames' spectral flux flags onsets while they are still half a window away
+  from the output; the short processor then starts transforming, the output crossfades
+  over to it before the onset and back to the long window once it has passed. Both paths
+  are normalised on their own and the crossfade gains sum to one, so the switch is
+  level-neutral and the latency never changes. Away from onsets the short processor skips
+  its transforms.
+
+  The engine also owns the SpectralChain sized for its bands, so the chain's state is
+  built and swapped together with the engine. Every frame is tagged with the index of the
+  band it came from, which is how the chain's modules find their per-band state.
+
+  A batched engine shares the process-wide FFTBatchScheduler with every other batched
+  engine, so same-size frames from all of them are transformed together.
+ */
+class SpectralEngine
+{
+public:
+    static constexpr int minBandSize = 256;
+    static constexpr int maxChunkSize = 512;
+    // Where the masks cross over, each with two octaves of transition. Only used from
+    // minMultiResolutionSize up at 48 kHz, where the smallest band still has the bins to
+    // resolve them; a higher rate spreads the bins wider, so it needs a larger size.
+    static constexpr std::array<double, 2> crossoverFrequencies{400.0, 3200.0};
+    static constexpr int minMultiResolutionSize = 8192;
+
+    explicit SpectralEngine(const SpectralEngineConfig& newConfig)
+        : config(newConfig)
+    {
+        jassert(config.numChannels <= maxChannels);
+
+        if (config.batched)
+            scheduler.emplace();
+
+        std::vector<int> bandSizes{config.fftSize};
+        if (isMultiResolution())
+        {
+            for (auto divisor : {4, 16})
+                bandSizes.push_back(getReducedSize(divisor));
+        }
+        else if (config.mode == SpectralEngineConfig::Mode::transientAdaptive)
+        {
+            bandSizes.push_back(getReducedSize(8));
+        }
+
+        for (auto bandSize : bandSizes)
+        {
+            auto band = std::make_unique<Band>();
+            band->processor = std::make_unique<FFTProcessor>(bandSize, config.overlapOrder, config.numChannels, config.numSpectralChannels,
+                                                             scheduler ? &scheduler->get() : nullptr);
+            bands.push_back(std::move(band));
+        }
+
+        latency = bands.front()->processor->getLatencyInSamples();
+
+        for (size_t b = 1; b < bands.size(); ++b)
+        {
+            auto& band = *bands[b];
+            band.delay = latency - band.processor->getLatencyInSamples();
+            band.delayLine.resize((size_t) (band.delay * config.numChannels));
+            band.output.setSize(config.numChannels, maxChunkSize);
+        }
+
+        dry.delay = latency;
+        dry.delayLine.resize((size_t) (dry.delay * config.numChannels));
+
+        if (isMultiResolution())
+        {
+            for (size_t b = 0; b < bands.size(); ++b)
+                computeBandMask(*bands[b], (int) b);
+        }
+        else if (config.mode == SpectralEngineConfig::Mode::transientAdaptive)
+        {
+            const auto numBins = config.fftSize / 2 + 1;
+            previousMagnitudes.resize((size_t) (numBins * config.numSpectralChannels));
+            delayedInput.setSize(config.numChannels, maxChunkSize);
+            shortOutput.setSize(config.numChannels, maxChunkSize);
+        }
+
+        SpectralModuleSpec spec;
+        for (auto& band : bands)
+        {
+            spec.bandSizes.push_back(band->processor->getFFTSize());
+            spec.bandHops.push_back(band->processor->getHopSize());
+        }
+        spec.numChannels = config.numSpectralChannels;
+        spec.sampleRate = config.sampleRate;
+        chain.prepare(spec);
+    }
+
+    void reset()
+    {
+        for (auto& band : bands)
+        {
+            band->processor->reset();
+            std::fill(band->delayLine.begin(), band->delayLine.end(), 0.0f);
+            band->delayPosition = 0;
+        }
+
+        std::fill(dry.delayLine.begin(), dry.delayLine.end(), 0.0f);
+        dry.delayPosition = 0;
+
+        std::fill(previousMagnitudes.begin(), previousMagnitudes.end(), 0.0f);
+        averageFlux = 0.0f;
+        onsetDetected = false;
+        switchState = SwitchState::longWindow;
+        switchCountdown = 0;
+        shortGain = 0.0f;
+
+        chain.reset();
+    }
+
+    // Offline only: every band records into or replays from its own track of the cache.
+    // Attach after reset(); nullptr detaches.
+    void setAnalysisCache(SpectralAnalysisCache* cache)
+    {
+        for (size_t b = 0; b < bands.size(); ++b)
+            bands[b]->processor->setAnalysisCache(cache, (int) b);
+    }
+
+    // Every band times its stages into the counters; nullptr stops.
+    void setPerformanceCounters(PerformanceCounters* counters)
+    {
+        for (auto& band : bands)
+            band->processor->setPerformanceCounters(counters);
+    }
+
+    template <typename FProcess>
+    void process(const float* const* input, float* const* output, int numSamples, bool bypassed, FProcess process_fn)
+    {
+        if (bands.size() == 1)
+        {
+            bands.front()->processor->process(input, output, numSamples, bypassed, process_fn);
+            return;
+        }
+
+        if (config.mode == SpectralEngineConfig::Mode::transientAdaptive)
+        {
+            processTransientAdaptive(input, output, numSamples, bypassed, process_fn);
+            return;
+        }
+
+        const float* chunkInput[maxChannels];
+        float* chunkOutput[maxChannels];
+
+        for (int start = 0; start < numSamples; start += maxChunkSize)
+        {
+            const auto chunk = juce::jmin(maxChunkSize, numSamples - start);
+            for (int c = 0; c < config.numChannels; ++c)
+            {
+                chunkInput[c] = input[c] + start;
+                chunkOutput[c] = output[c] + start;
+            }
+
+            for (size_t b = 0; b < bands.size(); ++b)
+            {
+                auto& band = *bands[b];
+                // Bands always run their transforms, since the masks are what split the signal.
+                auto bandProcess = [&process_fn, &band, b, bypassed](SpectralFrame& frame)
+                {
+                    frame.band = (int) b;
+                    if (!bypassed)
+                        process_fn(frame);
+                    applyBandMask(frame, band.mask);
+                };
+
+                // The low band has the longest latency, so it goes straight to the output
+                // and every other band is delayed up to it and added on top.
+                if (b == 0)
+                {
+                    band.processor->process(chunkInput, chunkOutput, chunk, false, bandProcess);
+                    continue;
+                }
+
+                band.processor->process(chunkInput, band.output.getArrayOfWritePointers(), chunk, false, bandProcess);
+                delayBand(band, band.output.getArrayOfReadPointers(), chunkOutput, chunk, true);
+            }
+        }
+    }
+
+    // The input delayed by the engine's latency, to mix back in with the output or pass
+    // through while bypassed. Has to run every block to stay in step; may be in place.
+    void delayDry(const float* const* input, float* const* output, int numSamples)
+    {
+        delayBand(dry, input, output, numSamples, false);
+    }
+
+    SpectralChain& getChain() { return chain; }
+    const SpectralEngineConfig& getConfig() const { return config; }
+    int getFFTSize() const { return config.fftSize; }
+    int getNumChannels() const { return config.numChannels; }
+    int getNumSpectralChannels() const { return config.numSpectralChannels; }
+    int getLatencyInSamples() const { return latency; }
+
+    // Every band's buffers and delay lines, and the spectral chain's state.
+    size_t getMemoryFootprint() const
+    {
+        auto bytes = chain.getMemoryFootprint();
+        bytes += (dry.delayLine.capacity() + previousMagnitudes.capacity()) * sizeof(float);
+        for (const auto& buffer : {&delayedInput, &shortOutput})
+            bytes += (size_t) (buffer->getNumChannels() * buffer->getNumSamples()) * sizeof(float);
+
+        for (const auto& band : bands)
+        {
+            bytes += band->processor->getMemoryFootprint();
+            bytes += (band->mask.capacity() + band->delayLine.capacity()) * sizeof(float);
+            bytes += (size_t) (band->output.getNumChannels() * band->output.getNumSamples()) * sizeof(float);
+        }
+
+        return bytes;
+    }
+
+    // Every band's hop boundaries line up at multiples of this.
+    int getHopAlignment() const
+    {
+        auto alignment = 1;
+        for (auto& band : bands)
+            alignment = std::lcm(alignment, band->processor->getHopSize());
+
+        return alignment;
+    }
+
+    // True when each output sample depends only on the frames around it, so the signal can
+    // be rendered in independent pieces. The onset detector in transient adaptive mode
+    // keeps a running average, and freeze and smear keep past frames.
+    bool isFrameLocal() const
+    {
+        return config.mode != SpectralEngineConfig::Mode::transientAdaptive && chain.isFrameLocal();
+    }
+
+    // Input samples taken in since the last reset, which is what SpectralFrame::samplePosition counts.
+    juce::int64 getSamplePosition() const { return bands.front()->processor->getSamplesProcessed(); }
+
+private:
+    static constexpr int maxChannels = 16;
+
+    // An onset is a frame whose flux jumps this far over the running average of the flux.
+    static constexpr float onsetRatio = 2.5f;
+    static constexpr float averageFluxSmoothing = 0.8f;
+    static constexpr float minimumFlux = 1.0e-3f;
+
+    enum class SwitchState { longWindow, waitingForShort, fadingToShort, holdingShort, fadingToLong };
+
+    struct Band
+    {
+        std::unique_ptr<FFTProcessor> processor;
+        std::vector<float> mask;
+        juce::AudioBuffer<float> output;
+        std::vector<float> delayLine;
+        int delay = 0;
+        int delayPosition = 0;
+    };
+
+    bool isMultiResolution() const
+    {
+        const auto minSize = minMultiResolutionSize * juce::jmax(1.0, config.sampleRate / 48000.0);
+        return config.mode == SpectralEngineConfig::Mode::multiResolution && config.fftSize >= minSize;
+    }
+
+    int getReducedSize(int divisor) const
+    {
+        // Dividing a mixed radix size can leave an odd factor, so round back up.
+        auto reducedSize = juce::jmax(minBandSize, config.fftSize / divisor);
+        while (!MixedRadixFFT::isSupportedSize(reducedSize))
+            reducedSize *= 2;
+
+        return reducedSize;
+    }
+
+    template <typename FProcess>
+    void processTransientAdaptive(const float* const* input, float* const* output, int numSamples, bool bypassed, FProcess& process_fn)
+    {
+        auto& longBand = *bands[0];
+        auto& shortBand = *bands[1];
+
+        auto longProcess = [this, &process_fn](SpectralFrame& frame)
+        {
+            detectOnset(frame);
+            process_fn(frame);
+        };
+
+        auto shortProcess = [&process_fn](SpectralFrame& frame)
+        {
+            frame.band = 1;
+            process_fn(frame);
+        };
+
+        const float* chunkInput[maxChannels];
+        float* chunkOutput[maxChannels];
+
+        for (int start = 0; start < numSamples; start += maxChunkSize)
+        {
+            const auto chunk = juce::jmin(maxChunkSize, numSamples - start);
+            for (int c = 0; c < config.numChannels; ++c)
+            {
+                chunkInput[c] = input[c] + start;
+                chunkOutput[c] = output[c] + start;
+            }
+
+            // Bypassed, neither path transforms: there's nothing to switch between.
+            longBand.processor->process(chunkInput, chunkOutput, chunk, bypassed, longProcess);
+
+            if (onsetDetected)
+            {
+                onsetDetected = false;
+                startShortWindows();
+            }
+
+            // The short path always runs so its FIFOs stay current, but only transforms
+            // while it can be heard.
+            const auto shortBypassed = bypassed || switchState == SwitchState::longWindow;
+            delayBand(shortBand, chunkInput, delayedInput.getArrayOfWritePointers(), chunk, false);
+            shortBand.processor->process(delayedInput.getArrayOfReadPointers(), shortOutput.getArrayOfWritePointers(),
+                                         chunk, shortBypassed, shortProcess);
+
+            crossfadeToShort(chunkOutput, chunk);
+        }
+    }
+
+    void detectOnset(const SpectralFrame& frame)
+    {
+        auto flux = 0.0f;
+        for (int c = 0; c < frame.numChannels; ++c)
+        {
+            float* previous = previousMagnitudes.data() + c * frame.numBins;
+            for (int bin = 1; bin < frame.numBins; ++bin)
+            {
+                const auto re = frame.real[bin * frame.stride + c];
+                const auto im = frame.imag[bin * frame.stride + c];
+                const auto magnitude = std::sqrt(re * re + im * im);
+                flux += juce::jmax(0.0f, magnitude - previous[bin]);
+                previous[bin] = magnitude;
+            }
+        }
+
+        if (flux > minimumFlux && flux > onsetRatio * averageFlux)
+            onsetDetected = true;
+
+        averageFlux = averageFluxSmoothing * averageFlux + (1.0f - averageFluxSmoothing) * flux;
+    }
+
+    void startShortWindows()
+    {
+        // The onset sits near the middle of the frame that flagged it, so it reaches the
+        // output about half a long window from now. Give the short path its own latency to
+        // fill with transformed frames, then fade across before the onset arrives.
+        const auto shortLatency = bands[1]->processor->getLatencyInSamples();
+
+        switch (switchState)
+        {
+            case SwitchState::longWindow:
+                switchState = SwitchState::waitingForShort;
+                switchCountdown = shortLatency;
+                break;
+            case SwitchState::holdingShort:
+            case SwitchState::fadingToLong:
+                switchState = SwitchState::fadingToShort;
+                break;
+            case SwitchState::waitingForShort:
+            case SwitchState::fadingToShort:
+                break;
+        }
+    }
+
+    void crossfadeToShort(float* const* output, int numSamples)
+    {
+        const auto fadeStep = 4.0f / (float) config.fftSize;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            switch (switchState)
+            {
+                case SwitchState::longWindow:
+                    break;
+                case SwitchState::waitingForShort:
+                    if (--switchCountdown <= 0)
+                        switchState = SwitchState::fadingToShort;
+                    break;
+                case SwitchState::fadingToShort:
+                    shortGain = juce::jmin(1.0f, shortGain + fadeStep);
+                    if (shortGain >= 1.0f)
+                    {
+                        // Stay short until the long window's smear around the onset is out.
+                        switchState = SwitchState::holdingShort;
+                        switchCountdown = config.fftSize;
+                    }
+                    break;
+                case SwitchState::holdingShort:
+                    if (--switchCountdown <= 0)
+                        switchState = SwitchState::fadingToLong;
+                    break;
+                case SwitchState::fadingToLong:
+                    shortGain = juce::jmax(0.0f, shortGain - fadeStep);
+                    if (shortGain <= 0.0f)
+                        switchState = SwitchState::longWindow;
+                    break;
+            }
+
+            if (shortGain > 0.0f)
+            {
+                for (int c = 0; c < config.numChannels; ++c)
+                {
+                    const auto shortSample = shortOutput.getReadPointer(c)[i];
+                    output[c][i] += shortGain * (shortSample - output[c][i]);
+                }
+            }
+        }
+    }
+
+    void computeBandMask(Band& band, int index) const
+    {
+        const auto fftSize = band.processor->getFFTSize();
+        const auto numBins = fftSize / 2 + 1;
+        const auto lastBand = (int) crossoverFrequencies.size();
+
+        // Weight of everything below a crossover: 1 from an octave under it, 0 from an
+        // octave over it, raised cosine in log frequency in between.
+        auto lowWeight = [](double frequency, double crossover)
+        {
+            const auto t = juce::jlimit(0.0, 1.0, 0.5 * std::log2(frequency / crossover) + 0.5);
+            return 0.5 * (1.0 + std::cos(juce::MathConstants<double>::pi * t));
+        };
+
+        band.mask.resize((size_t) numBins);
+        for (int bin = 0; bin < numBins; ++bin)
+        {
+            const auto frequency = juce::jmax(1.0, bin * config.sampleRate / fftSize);
+            const auto below = index == lastBand ? 1.0 : lowWeight(frequency, crossoverFrequencies[(size_t) index]);
+            const auto belowPrevious = index == 0 ? 0.0 : lowWeight(frequency, crossoverFrequencies[(size_t) index - 1]);
+            band.mask[(size_t) bin] = (float) (below - belowPrevious);
+        }
+    }
+
+    static void applyBandMask(SpectralFrame& frame, const std::vector<float>& mask)
+    {
+        constexpr int lanes = SpectralFrame::laneGroupSize;
+
+        for (int bin = 0; bin < frame.numBins; ++bin)
+        {
+            float* re = frame.real + bin * frame.stride;
+            float* im = frame.imag + bin * frame.stride;
+            const auto gain = mask[(size_t) bin];
+
+            for (int group = 0; group < frame.stride; group += lanes)
+            {
+                for (int l = group; l < group + lanes; ++l)
+                {
+                    re[l] *= gain;
+                    im[l] *= gain;
+                }
+            }
+        }
+    }
+
+    // Runs a band's signal through its delay line, either replacing or adding to the output.
+    void delayBand(Band& band, const float* const* input, float* const* output, int numSamples, bool accumulate)
+    {
+        if (band.delay == 0)
+        {
+            for (int c = 0; c < config.numChannels; ++c)
+            {
+                if (accumulate)
+                    juce::FloatVectorOperations::add(output[c], input[c], numSamples);
+                else if (output[c] != input[c])
+                    juce::FloatVectorOperations::copy(output[c], input[c], numSamples);
+            }
+            return;
+        }
+
+        auto position = band.delayPosition;
+        for (int c = 0; c < config.numChannels; ++c)
+        {
+            float* line = band.delayLine.data() + c * band.delay;
+            position = band.delayPosition;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto sample = input[c][i];
+                output[c][i] = accumulate ? output[c][i] + line[position] : line[position];
+                line[position] = sample;
+                if (++position == band.delay)
+                    position = 0;
+            }
+        }
+        band.delayPosition = position;
+    }
+
+    SpectralEngineConfig config;
+    std::optional<juce::SharedResourcePointer<FFTBatchScheduler>> scheduler;
+    std::vector<std::unique_ptr<Band>> bands;
+    Band dry;
+    SpectralChain chain;
+    int latency = 0;
+
+    std::vector<float> previousMagnitudes;
+    juce::AudioBuffer<float> delayedInput, shortOutput;
+    float averageFlux = 0.0f;
+    bool onsetDetected = false;
+    SwitchState switchState = SwitchState::longWindow;
+    int switchCountdown = 0;
+    float shortGain = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectralEngine)
+};
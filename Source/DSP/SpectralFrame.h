@@ -0,0 +1,30 @@
+#pragma once
+
+/*
+  One hop's worth of spectra for every channel, stored channel-interleaved: bin b of
+  channel c lives at [b * stride + c]. stride is the channel count rounded up to a whole
+  lane group, so the kernels can run the inner channel loop as fixed-width SIMD; the
+  padding channels are kept at zero.
+ */
+struct SpectralFrame
+{
+    static constexpr int laneGroupSize = 4;
+
+    static int strideForChannels(int numChannels)
+    {
+        return (numChannels + laneGroupSize - 1) / laneGroupSize * laneGroupSize;
+    }
+
+    float* real = nullptr;
+    float* imag = nullptr;
+    float* magnitude = nullptr; // scratch plane, same layout, free for kernels to use
+    int numBins = 0;
+    int numChannels = 0;
+    int stride = 0;
+    int band = 0; // which of the engine's bands (window sizes) the frame came from
+    long long samplePosition = 0; // input samples the band had taken in when the frame was captured
+
+    // The bins kernels should touch, [firstBin, endBin). The rest pass through as they are.
+    int firstBin = 0;
+    int endBin = 0;
+};
@@ -0,0 +1,333 @@
+#pragma once
+#include "HalfFloat.h"
+#include "SpectralModule.h"
+
+/*
+  Freeze and smear, both built on a ring of each band's recent magnitudes.
+
+  Smear replaces every bin's magnitude with its average over the last smear time, keeping
+  the live phases. The history is stored as half floats, scaled so a full scale sine sits
+  at 1024, which keeps about 144 dB of range in half the memory of floats. The running
+  sums are kept in whole steps of the smallest half (see HalfFloat::toSteps), which no
+  ring can overflow, so they stay exact and never drift however long the history, and
+  each frame costs one add and one subtract per bin whatever the smear length. Every bin's
+  history moves on each frame, not just those in the chain's frequency range, so the sums
+  stay true to the ring when the range changes; only the bins in range are smeared.
+
+  A new smear length moves the window at most maxLengthStep frames a hop, adding the
+  frames that come into it and taking out those that leave, so automating smear costs a
+  few frames' work rather than a rebuild of every sum.
+
+  The ring holds maxSmearSeconds of frames at the band's hop, 2 bytes a bin, which comes
+  to about the sample rate times the overlap in bytes per second per channel and band:
+  a 768 kB ring for a stereo band at 48 kHz and an overlap of 4. Small hops at high rates
+  with many channels would need far more (147 MB a band at 192 kHz, an overlap of 32 and
+  12 channels), so each band's ring is capped at maxHistoryBytes and smear tops out at
+  whatever fits. The ring is only allocated once smear is wanted. Until then
+  needsHistory() says so, and allocateHistory(), off the audio thread, builds it for the
+  audio thread to pick up at its next frame. It's kept from then on, so automation that
+  touches zero doesn't allocate again; the frames before that pass through unsmeared.
+
+  Freeze holds the spectrum that was coming in when it was switched on (smeared, if smear
+  is up). Each band captures its next two frames and then keeps resynthesising the second:
+  its magnitudes, with every bin's phase advanced each hop by what it moved between the
+  two captured frames. That is the bin's measured frequency rather than its centre
+  frequency, so the leakage bins around a partial stay in phase with it and a held tone
+  sustains cleanly. Every bin is captured and keeps advancing while held, so bins that
+  come into range during a hold pick up where they would have been.
+ */
+class SpectralFreeze : public SpectralModule
+{
+public:
+    static constexpr double maxSmearSeconds = 2.0;
+    static constexpr size_t maxHistoryBytes = (size_t) 16 << 20;
+    static constexpr int maxLengthStep = 4;
+
+    ~SpectralFreeze() override
+    {
+        delete incomingHistory.exchange(nullptr);
+    }
+
+    void prepare(const SpectralModuleSpec& spec) override
+    {
+        history.reset();
+        delete incomingHistory.exchange(nullptr);
+        historyBytes = 0;
+        historyAllocated = false;
+
+        stride = spec.getStride();
+        numChannels = spec.numChannels;
+        bands.resize((size_t) spec.getNumBands());
+
+        for (int b = 0; b < spec.getNumBands(); ++b)
+        {
+            auto& band = bands[(size_t) b];
+            const auto numBins = spec.getNumBins(b);
+            const auto hop = spec.bandHops[(size_t) b];
+
+            band.magnitude.assign((size_t) (numBins * stride), 0.0f);
+            band.phase.assign((size_t) (numBins * stride), 0.0f);
+            band.phaseAdvance.assign((size_t) (numBins * stride), 0.0f);
+            band.expectedAdvance.resize((size_t) numBins);
+
+            for (int bin = 0; bin < numBins; ++bin)
+            {
+                const auto advance = juce::MathConstants<double>::twoPi * bin * hop / spec.bandSizes[(size_t) b];
+                band.expectedAdvance[(size_t) bin] = (float) std::fmod(advance, juce::MathConstants<double>::twoPi);
+            }
+
+            band.framesPerSecond = spec.sampleRate / hop;
+            band.valuesPerFrame = numBins * numChannels;
+            const auto maxFrames = (int) (maxHistoryBytes / ((size_t) band.valuesPerFrame * sizeof(uint16_t)));
+            band.historyFrames = juce::jlimit(2, juce::jmax(2, maxFrames), (int) std::ceil(maxSmearSeconds * band.framesPerSecond) + 1);
+            band.historyScale = 4096.0f / (float) spec.bandSizes[(size_t) b];
+        }
+
+        smearSeconds = -1.0f;
+        setSmear(0.0f);
+    }
+
+    void reset() override
+    {
+        for (auto& band : bands)
+            band.framesCaptured = 0;
+
+        if (history != nullptr)
+            clearHistory();
+    }
+
+    // Off the audio thread: builds the ring if it isn't there yet. Called for the
+    // processor once needsHistory() asks, or up front by anything that can't wait.
+    void allocateHistory()
+    {
+        if (historyAllocated)
+            return;
+
+        auto newHistory = std::make_unique<SmearHistory>();
+        for (const auto& band : bands)
+        {
+            auto& bandHistory = newHistory->bands.emplace_back();
+            bandHistory.ring.assign((size_t) (band.historyFrames * band.valuesPerFrame), 0);
+            bandHistory.sum.assign((size_t) band.valuesPerFrame, 0);
+        }
+
+        historyAllocated = true;
+        incomingHistory.store(newHistory.release(), std::memory_order_release);
+    }
+
+    // Audio thread: smear is on but has no ring to run on yet.
+    bool needsHistory() const { return smearSeconds > 0.0f && history == nullptr; }
+
+    // The per-band state and, once allocated, the smear ring.
+    size_t getMemoryFootprint() const override
+    {
+        size_t bytes = historyBytes.load(std::memory_order_relaxed);
+        for (const auto& band : bands)
+            bytes += (band.magnitude.capacity() + band.phase.capacity() + band.phaseAdvance.capacity()
+                      + band.expectedAdvance.capacity()) * sizeof(float);
+
+        return bytes;
+    }
+
+    void setFrozen(bool shouldFreeze)
+    {
+        if (frozen && !shouldFreeze)
+        {
+            for (auto& band : bands)
+                band.framesCaptured = 0;
+        }
+
+        frozen = shouldFreeze;
+    }
+
+    void setSmear(float newSmearSeconds)
+    {
+        if (newSmearSeconds == smearSeconds)
+            return;
+
+        smearSeconds = newSmearSeconds;
+        for (auto& band : bands)
+            band.smearFrames = juce::jlimit(1, band.historyFrames - 1, (int) std::round(smearSeconds * band.framesPerSecond));
+    }
+
+    bool isActive() const override { return frozen || smearSeconds > 0.0f; }
+
+    void process(SpectralFrame& frame) override
+    {
+        if (history == nullptr)
+            adoptHistory();
+
+        auto& band = bands[(size_t) frame.band];
+        const auto holding = frozen && band.framesCaptured >= 2;
+
+        if (band.smearFrames > 1 && !holding && history != nullptr)
+            smear(frame, band, history->bands[(size_t) frame.band]);
+
+        if (!frozen)
+            return;
+
+        if (holding)
+            resynthesise(frame, band);
+        else
+            capture(frame, band);
+    }
+
+private:
+    struct Band
+    {
+        std::vector<float> magnitude, phase, phaseAdvance, expectedAdvance;
+        int framesCaptured = 0;
+
+        double framesPerSecond = 0.0;
+        float historyScale = 1.0f;
+        int historyFrames = 0, valuesPerFrame = 0;
+        int writeFrame = 0, smearFrames = 1, sumLength = 0;
+    };
+
+    // Each band's ring of past magnitudes and, for every value, the sum of the last
+    // sumLength frames of it in half float steps.
+    struct SmearHistory
+    {
+        struct Band
+        {
+            std::vector<uint16_t> ring;
+            std::vector<int64_t> sum;
+        };
+
+        std::vector<Band> bands;
+    };
+
+    void adoptHistory()
+    {
+        history.reset(incomingHistory.exchange(nullptr, std::memory_order_acquire));
+        if (history == nullptr)
+            return;
+
+        size_t bytes = 0;
+        for (const auto& bandHistory : history->bands)
+            bytes += bandHistory.ring.capacity() * sizeof(uint16_t) + bandHistory.sum.capacity() * sizeof(int64_t);
+
+        historyBytes.store(bytes, std::memory_order_relaxed);
+        clearHistory();
+    }
+
+    // An empty ring sums to zero over any length, so the sums can start at the current one.
+    void clearHistory()
+    {
+        for (size_t b = 0; b < bands.size(); ++b)
+        {
+            auto& bandHistory = history->bands[b];
+            std::fill(bandHistory.ring.begin(), bandHistory.ring.end(), (uint16_t) 0);
+            std::fill(bandHistory.sum.begin(), bandHistory.sum.end(), (int64_t) 0);
+            bands[b].writeFrame = 0;
+            bands[b].sumLength = bands[b].smearFrames;
+        }
+    }
+
+    uint16_t* getHistoryFrame(const Band& band, SmearHistory::Band& bandHistory, int framesAgo) const
+    {
+        const auto index = (band.writeFrame - framesAgo + band.historyFrames) % band.historyFrames;
+        return bandHistory.ring.data() + index * band.valuesPerFrame;
+    }
+
+    void addToSums(const Band& band, SmearHistory::Band& bandHistory, int framesAgo, int64_t sign) const
+    {
+        const auto* stored = getHistoryFrame(band, bandHistory, framesAgo);
+        for (int i = 0; i < band.valuesPerFrame; ++i)
+            bandHistory.sum[(size_t) i] += sign * HalfFloat::toSteps(stored[i]);
+    }
+
+    void smear(SpectralFrame& frame, Band& band, SmearHistory::Band& bandHistory)
+    {
+        // The sums cover the frames 1 to sumLength ago.
+        for (int step = 0; step < maxLengthStep && band.sumLength != band.smearFrames; ++step)
+        {
+            if (band.sumLength < band.smearFrames)
+                addToSums(band, bandHistory, ++band.sumLength, 1);
+            else
+                addToSums(band, bandHistory, band.sumLength--, -1);
+        }
+
+        const auto* oldest = getHistoryFrame(band, bandHistory, band.sumLength);
+        auto* newest = getHistoryFrame(band, bandHistory, 0);
+        const auto toMagnitude = HalfFloat::stepSize / (band.historyScale * band.sumLength);
+        const auto numBins = band.valuesPerFrame / numChannels;
+
+        for (int bin = 0; bin < numBins; ++bin)
+        {
+            const auto inRange = bin >= frame.firstBin && bin < frame.endBin;
+
+            for (int c = 0; c < numChannels; ++c)
+            {
+                const auto i = bin * frame.stride + c;
+                const auto stored = bin * numChannels + c;
+                const auto magnitude = getMagnitude(frame.real[i], frame.imag[i]);
+
+                const auto code = HalfFloat::fromFloat(magnitude * band.historyScale);
+                auto& sum = bandHistory.sum[(size_t) stored];
+                sum += HalfFloat::toSteps(code) - HalfFloat::toSteps(oldest[stored]);
+                newest[stored] = code;
+
+                if (inRange)
+                    setMagnitude(frame.real[i], frame.imag[i], magnitude, (float) ((double) sum * toMagnitude));
+            }
+        }
+
+        band.writeFrame = (band.writeFrame + 1) % band.historyFrames;
+    }
+
+    // Both captured frames pass through untouched.
+    void capture(const SpectralFrame& frame, Band& band) const
+    {
+        for (int bin = 0; bin < frame.numBins; ++bin)
+        {
+            const auto expected = band.expectedAdvance[(size_t) bin];
+
+            for (int c = 0; c < stride; ++c)
+            {
+                const auto i = bin * stride + c;
+                const auto phase = std::atan2(frame.imag[i], frame.real[i]);
+
+                // The deviation from the bin centre's advance is within half a turn for
+                // anything inside the bin's main lobe, so wrap it before adding it back.
+                const auto deviation = std::remainder(phase - band.phase[(size_t) i] - expected, juce::MathConstants<float>::twoPi);
+                band.phaseAdvance[(size_t) i] = expected + deviation;
+                band.phase[(size_t) i] = phase;
+                band.magnitude[(size_t) i] = getMagnitude(frame.real[i], frame.imag[i]);
+            }
+        }
+
+        ++band.framesCaptured;
+    }
+
+    void resynthesise(SpectralFrame& frame, Band& band) const
+    {
+        for (int bin = 0; bin < frame.numBins; ++bin)
+        {
+            const auto offset = bin * stride;
+            const auto inRange = bin >= frame.firstBin && bin < frame.endBin;
+
+            for (int c = 0; c < frame.numChannels; ++c)
+            {
+                auto& phase = band.phase[(size_t) (offset + c)];
+                phase = std::remainder(phase + band.phaseAdvance[(size_t) (offset + c)], juce::MathConstants<float>::twoPi);
+                if (!inRange)
+                    continue;
+
+                const auto magnitude = band.magnitude[(size_t) (offset + c)];
+                frame.real[offset + c] = magnitude * std::cos(phase);
+                frame.imag[offset + c] = magnitude * std::sin(phase);
+            }
+        }
+    }
+
+    std::vector<Band> bands;
+    std::unique_ptr<SmearHistory> history;
+    std::atomic<SmearHistory*> incomingHistory{nullptr};
+    std::atomic<size_t> historyBytes{0};
+    // Only touched off the audio thread, by prepare() and allocateHistory().
+    bool historyAllocated = false;
+    int stride = 0, numChannels = 0;
+    bool frozen = false;
+    float smearSeconds = 0.0f;
+};
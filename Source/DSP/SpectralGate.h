@@ -0,0 +1,59 @@
+#pragma once
+#include "SpectralModule.h"
+
+/*
+  Silences every bin whose level is under the threshold. The threshold is in dBFS: a full
+  scale sine peaks at fftSize / 4 through the hann window, so each band scales it by its
+  own size.
+ */
+class SpectralGate : public SpectralModule
+{
+public:
+    static constexpr float offThreshold = -100.0f;
+
+    void prepare(const SpectralModuleSpec& spec) override
+    {
+        bandSizes = spec.bandSizes;
+        thresholds.assign(bandSizes.size(), 0.0f);
+
+        threshold = 0.0f;
+        setThreshold(offThreshold);
+    }
+
+    void setThreshold(float newThresholdDecibels)
+    {
+        if (newThresholdDecibels == threshold)
+            return;
+
+        threshold = newThresholdDecibels;
+        const auto gain = juce::Decibels::decibelsToGain(threshold, offThreshold);
+        for (size_t b = 0; b < bandSizes.size(); ++b)
+            thresholds[b] = gain * (float) bandSizes[b] * 0.25f;
+    }
+
+    bool isActive() const override { return threshold > offThreshold; }
+
+    size_t getMemoryFootprint() const override
+    {
+        return thresholds.capacity() * sizeof(float) + bandSizes.capacity() * sizeof(int);
+    }
+
+    void process(SpectralFrame& frame) override
+    {
+        const auto limit = thresholds[(size_t) frame.band];
+        const auto limitSquared = limit * limit;
+        const auto endValue = frame.endBin * frame.stride;
+
+        for (int i = frame.firstBin * frame.stride; i < endValue; ++i)
+        {
+            const auto open = frame.real[i] * frame.real[i] + frame.imag[i] * frame.imag[i] >= limitSquared;
+            frame.real[i] = open ? frame.real[i] : 0.0f;
+            frame.imag[i] = open ? frame.imag[i] : 0.0f;
+        }
+    }
+
+private:
+    std::vector<int> bandSizes;
+    std::vector<float> thresholds;
+    float threshold = offThreshold;
+};
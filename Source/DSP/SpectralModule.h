@@ -0,0 +1,61 @@
+#pragma once
+#include <cmath>
+#include <vector>
+#include "juce_audio_basics/juce_audio_basics.h"
+#include "SpectralFrame.h"
+
+/*
+  What a SpectralModule needs to size its state: the transform size and hop of every band
+  the engine runs (one, or several in multi resolution and adaptive modes), the number of
+  transformed channels and the sample rate.
+ */
+struct SpectralModuleSpec
+{
+    std::vector<int> bandSizes;
+    std::vector<int> bandHops;
+    int numChannels = 0;
+    double sampleRate = 44100.0;
+
+    int getNumBands() const { return (int) bandSizes.size(); }
+    int getNumBins(int band) const { return bandSizes[(size_t) band] / 2 + 1; }
+    int getStride() const { return SpectralFrame::strideForChannels(numChannels); }
+};
+
+/*
+  One effect in a SpectralChain. Every module runs on the same frame inside the engine's
+  single forward/inverse pair, so adding one costs no extra transforms or latency.
+
+  prepare() runs off the audio thread and is the only place a module may allocate; any
+  state that depends on the window size is kept per band, indexed by frame.band. The
+  setters and process() run on the audio thread.
+ */
+class SpectralModule
+{
+public:
+    virtual ~SpectralModule() = default;
+
+    virtual void prepare(const SpectralModuleSpec& spec) = 0;
+    virtual void reset() {}
+
+    // Inactive modules are skipped entirely.
+    virtual bool isActive() const { return true; }
+    virtual void process(SpectralFrame& frame) = 0;
+
+    // Bytes of state the module holds; may be read from any thread.
+    virtual size_t getMemoryFootprint() const { return 0; }
+
+protected:
+    // Gives a bin a new magnitude and keeps its phase. A silent bin has no phase, so it
+    // takes the target at phase 0.
+    static void setMagnitude(float& re, float& im, float magnitude, float target)
+    {
+        const auto scale = magnitude > 0.0f ? target / magnitude : 0.0f;
+        re = magnitude > 0.0f ? re * scale : target;
+        im *= scale;
+    }
+
+    static float getMagnitude(float re, float im)
+    {
+        return std::sqrt(re * re + im * im);
+    }
+};
@@ -0,0 +1,115 @@
+#pragma once
+#include "SpectralEngine.h"
+
+/*
+  The signal path around a SpectralEngine that the plugin and KrushDSP share: mid/side
+  into the engine and back out of it, the dry signal delayed to line up with the wet, and
+  the dry/wet mix. The gain stage after it is left to the caller.
+
+  Bypass keeps the engine running, so switching back in is seamless, and hands out the
+  delayed dry signal as it is, so nothing from the wet path gets through, not even a NaN.
+
+  prepare() is the only call that allocates. process() runs in place on any number of
+  samples, in pieces of the prepared block size.
+ */
+class SpectralPath
+{
+public:
+    struct Settings
+    {
+        // Only with two channels: the engine runs on mid and side instead of left and right.
+        bool midSide = false;
+        // No bins in the chain's range, so the engine can skip its transforms.
+        bool spectralBypassed = false;
+        bool bypassed = false;
+        float wetGain = 1.0f;
+    };
+
+    void prepare(int numChannels, int maxBlockSize)
+    {
+        wetBuffer.setSize(numChannels, maxBlockSize);
+        dryBuffer.setSize(numChannels, maxBlockSize);
+        midSideBuffer.setSize(2, maxBlockSize);
+    }
+
+    template <typename FProcess>
+    void process(SpectralEngine& engine, float* const* channels, int numSamples, const Settings& settings,
+                 FProcess process_fn, PerformanceCounters* counters = nullptr)
+    {
+        const auto numChannels = engine.getNumChannels();
+        const auto midSide = settings.midSide && numChannels == 2;
+        const auto chunkSize = wetBuffer.getNumSamples();
+        jassert(numChannels <= wetBuffer.getNumChannels());
+
+        for (int start = 0; start < numSamples; start += chunkSize)
+        {
+            const auto chunkLength = juce::jmin(chunkSize, numSamples - start);
+            juce::AudioBuffer<float> chunk(channels, numChannels, start, chunkLength);
+
+            if (midSide)
+            {
+                KRUSH_TIME_STAGE(counters, mix);
+                encodeMidSide(chunk.getReadPointer(0), chunk.getReadPointer(1), midSideBuffer.getWritePointer(0),
+                              midSideBuffer.getWritePointer(1), chunkLength);
+            }
+
+            const auto& input = midSide ? midSideBuffer : chunk;
+            engine.process(input.getArrayOfReadPointers(), wetBuffer.getArrayOfWritePointers(), chunkLength,
+                           settings.spectralBypassed, process_fn);
+
+            KRUSH_TIME_STAGE(counters, mix);
+            engine.delayDry(chunk.getArrayOfReadPointers(), dryBuffer.getArrayOfWritePointers(), chunkLength);
+
+            if (settings.bypassed)
+            {
+                for (int channel = 0; channel < numChannels; ++channel)
+                    chunk.copyFrom(channel, 0, dryBuffer, channel, 0, chunkLength);
+                continue;
+            }
+
+            if (midSide)
+                decodeMidSide(wetBuffer.getWritePointer(0), wetBuffer.getWritePointer(1), chunkLength);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                auto* data = chunk.getWritePointer(channel);
+                const auto* wet = wetBuffer.getReadPointer(channel);
+                const auto* dry = dryBuffer.getReadPointer(channel);
+                for (int i = 0; i < chunkLength; ++i)
+                    data[i] = wet[i] * settings.wetGain + dry[i] * (1 - settings.wetGain);
+            }
+        }
+    }
+
+    size_t getMemoryFootprint() const
+    {
+        size_t floats = 0;
+        for (const auto* buffer : {&wetBuffer, &dryBuffer, &midSideBuffer})
+            floats += (size_t) (buffer->getNumChannels() * buffer->getNumSamples());
+
+        return floats * sizeof(float);
+    }
+
+private:
+    static void encodeMidSide(const float* left, const float* right, float* mid, float* side, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            mid[i] = 0.5f * (left[i] + right[i]);
+            side[i] = 0.5f * (left[i] - right[i]);
+        }
+    }
+
+    static void decodeMidSide(float* left, float* right, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto mid = left[i];
+            const auto side = right[i];
+            left[i] = mid + side;
+            right[i] = mid - side;
+        }
+    }
+
+    juce::AudioBuffer<float> wetBuffer, dryBuffer, midSideBuffer;
+};
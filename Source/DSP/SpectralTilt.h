@@ -0,0 +1,100 @@
+#pragma once
+#include "SpectralModule.h"
+
+/*
+  Tilts the spectrum by a fixed number of dB per octave around pivotFrequency. Each band
+  keeps a table of its bins' distance from the pivot in octaves, divided by the 6.02 dB
+  a doubling is, so a bin's gain is exp2(tilt * exponent). setTilt() only stores the
+  tilt; each band rebuilds its gains in one pass over that table at its next frame, so
+  however often the tilt moves within a hop it costs one pass per band.
+ */
+class SpectralTilt : public SpectralModule
+{
+public:
+    static constexpr double pivotFrequency = 1000.0;
+
+    void prepare(const SpectralModuleSpec& spec) override
+    {
+        bands.resize((size_t) spec.getNumBands());
+
+        for (int b = 0; b < spec.getNumBands(); ++b)
+        {
+            auto& band = bands[(size_t) b];
+            const auto numBins = spec.getNumBins(b);
+            band.exponents.resize((size_t) numBins);
+            band.gains.assign((size_t) numBins, 1.0f);
+            band.gainsTilt = 0.0f;
+
+            // DC has no octave, so it follows the first bin.
+            for (int bin = 0; bin < numBins; ++bin)
+            {
+                const auto frequency = juce::jmax(1, bin) * spec.sampleRate / spec.bandSizes[(size_t) b];
+                band.exponents[(size_t) bin] = (float) (std::log2(frequency / pivotFrequency) / decibelsPerDoubling);
+            }
+        }
+
+        tilt = 0.0f;
+    }
+
+    void setTilt(float newTiltDecibelsPerOctave) { tilt = newTiltDecibelsPerOctave; }
+
+    bool isActive() const override { return tilt != 0.0f; }
+
+    size_t getMemoryFootprint() const override
+    {
+        size_t bytes = 0;
+        for (const auto& band : bands)
+            bytes += (band.exponents.capacity() + band.gains.capacity()) * sizeof(float);
+
+        return bytes;
+    }
+
+    void process(SpectralFrame& frame) override
+    {
+        constexpr int lanes = SpectralFrame::laneGroupSize;
+        auto& band = bands[(size_t) frame.band];
+
+        if (band.gainsTilt != tilt)
+        {
+            const auto numBins = band.gains.size();
+            const auto* exponents = band.exponents.data();
+            auto* gains = band.gains.data();
+            for (size_t bin = 0; bin < numBins; ++bin)
+                gains[bin] = std::exp2(tilt * exponents[bin]);
+
+            band.gainsTilt = tilt;
+        }
+
+        const auto& gains = band.gains;
+
+        for (int bin = frame.firstBin; bin < frame.endBin; ++bin)
+        {
+            float* re = frame.real + bin * frame.stride;
+            float* im = frame.imag + bin * frame.stride;
+            const auto gain = gains[(size_t) bin];
+
+            for (int group = 0; group < frame.stride; group += lanes)
+            {
+                for (int l = group; l < group + lanes; ++l)
+                {
+                    re[l] *= gain;
+                    im[l] *= gain;
+                }
+            }
+        }
+    }
+
+private:
+    // 20 * log10(2), the dB in a doubling of gain.
+    static constexpr double decibelsPerDoubling = 6.020599913279624;
+
+    struct Band
+    {
+        std::vector<float> exponents, gains;
+        // The tilt the gains were last built for.
+        float gainsTilt = 0.0f;
+    };
+
+    std::vector<Band> bands;
+    float tilt = 0.0f;
+};
@@ -0,0 +1,19 @@
+#pragma once
+#include <array>
+
+/*
+  Window sizes offered on top of the power of two `order` sizes. Every entry factors into
+  2, 3 and 5 so MixedRadixFFT can run it, and they fill in the gaps between the orders so
+  the latency can be matched to a budget instead of rounding up to the next power of two.
+ */
+namespace WindowSizes
+{
+    inline constexpr int minOrder = 8;
+    inline constexpr int maxOrder = 15;
+
+    // The `overlap` parameter: each window overlaps the next 2^order times.
+    inline constexpr int minOverlapOrder = 2;
+    inline constexpr int maxOverlapOrder = 5;
+
+    inline constexpr std::array<int, 8> mixedRadix{384, 640, 768, 1280, 1536, 2400, 3072, 6000};
+}
@@ -0,0 +1,95 @@
+#include "PerformanceOverlay.h"
+
+#if KRUSH_INSTRUMENTATION
+
+PerformanceOverlay::PerformanceOverlay(AudioPluginAudioProcessor& processorToShow)
+    : processor(processorToShow)
+{
+    setInterceptsMouseClicks(true, false);
+}
+
+void PerformanceOverlay::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::black.withAlpha(0.85f));
+
+    auto bounds = getLocalBounds().reduced(10);
+    const auto lineHeight = 18;
+    g.setFont(juce::FontOptions(juce::Font::getDefaultMonospacedFontName(), 13.0f, juce::Font::plain));
+
+    auto drawLine = [&](const juce::String& text, juce::Colour colour)
+    {
+        g.setColour(colour);
+        g.drawText(text, bounds.removeFromTop(lineHeight), juce::Justification::centredLeft);
+    };
+
+    auto budgetColour = [](double percent)
+    {
+        return percent < 50.0 ? juce::Colours::lightgreen : percent < 80.0 ? juce::Colours::orange : juce::Colours::red;
+    };
+
+    drawLine(getSettingsText(), juce::Colours::white);
+    drawLine("Callback " + juce::String(snapshot.callbackMicroseconds, 1) + " us, "
+             + juce::String(snapshot.budgetPercent, 1) + "% of budget", budgetColour(snapshot.budgetPercent));
+    drawLine("Worst    " + juce::String(snapshot.worstMicroseconds, 1) + " us, "
+             + juce::String(snapshot.worstBudgetPercent, 1) + "% of budget (click to reset)",
+             budgetColour(snapshot.worstBudgetPercent));
+    drawLine("Hops     " + juce::String(snapshot.hopsPerBlock) + " in the last block, all bands", juce::Colours::white);
+    bounds.removeFromTop(lineHeight / 2);
+
+    // One bar per stage, scaled to the whole callback.
+    const auto total = juce::jmax(1.0e-3, snapshot.callbackMicroseconds);
+    for (int s = 0; s < PerformanceCounters::numStages; ++s)
+    {
+        const auto stage = static_cast<PerformanceCounters::Stage>(s);
+        const auto microseconds = snapshot.stageMicroseconds[(size_t) s];
+        auto row = bounds.removeFromTop(lineHeight);
+
+        g.setColour(juce::Colours::white);
+        g.drawText(PerformanceCounters::getStageName(stage), row.removeFromLeft(90), juce::Justification::centredLeft);
+        g.drawText(juce::String(microseconds, 1) + " us", row.removeFromRight(80), juce::Justification::centredRight);
+
+        auto bar = row.reduced(4, 4).toFloat();
+        g.setColour(juce::Colours::white.withAlpha(0.15f));
+        g.fillRect(bar);
+        g.setColour(juce::Colours::skyblue);
+        g.fillRect(bar.withWidth(bar.getWidth() * (float) juce::jlimit(0.0, 1.0, microseconds / total)));
+    }
+}
+
+void PerformanceOverlay::mouseDown(const juce::MouseEvent&)
+{
+    processor.resetWorstCallback();
+}
+
+void PerformanceOverlay::visibilityChanged()
+{
+    if (isVisible())
+        startTimerHz(refreshRateHz);
+    else
+        stopTimer();
+}
+
+void PerformanceOverlay::timerCallback()
+{
+    snapshot = processor.getPerformanceCounters().getSnapshot();
+    repaint();
+}
+
+juce::String PerformanceOverlay::getSettingsText() const
+{
+    auto text = [this](const char* parameterID)
+    {
+        return processor.apvts.getParameter(parameterID)->getCurrentValueAsText();
+    };
+
+    const auto size = text("size");
+    juce::StringArray settings{size == "Off" ? text("order") : size, text("resolution")};
+    if (processor.apvts.getRawParameterValue("batch")->load() >= 0.5f)
+        settings.add("Shared FFTs");
+    if (text("oversampling") != "Off")
+        settings.add(text("oversampling") + " gain");
+
+    return settings.joinIntoString(", ");
+}
+
+#endif
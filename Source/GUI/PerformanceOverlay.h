@@ -0,0 +1,34 @@
+#pragma once
+#include "juce_gui_basics/juce_gui_basics.h"
+#include "../PluginProcessor.h"
+
+#if KRUSH_INSTRUMENTATION
+
+/*
+  Shows what the last audio callback cost, stage by stage, against the real-time budget,
+  with the worst callback so far and the settings that decide the cost. Polls the
+  processor's PerformanceCounters while visible; clicking resets the worst callback.
+ */
+class PerformanceOverlay : public juce::Component,
+                           private juce::Timer
+{
+public:
+    explicit PerformanceOverlay(AudioPluginAudioProcessor& processorToShow);
+
+    void paint(juce::Graphics& g) override;
+    void mouseDown(const juce::MouseEvent& event) override;
+    void visibilityChanged() override;
+
+private:
+    static constexpr int refreshRateHz = 15;
+
+    void timerCallback() override;
+    juce::String getSettingsText() const;
+
+    AudioPluginAudioProcessor& processor;
+    PerformanceCounters::Snapshot snapshot;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PerformanceOverlay)
+};
+
+#endif
@@ -0,0 +1,248 @@
+#include "LatencyProbe.h"
+#include <iostream>
+
+/*
+  krush-latency: checks that the latency Krush reports is the delay it actually has.
+
+    krush-latency [options]
+
+  Every combination of the --vary values is probed at every rate and block size; without
+  any --vary a built-in set covers every order, size, overlap, resolution, stereo mode,
+  oversampling factor and the mix and bypass paths. A run fails if the measured delay
+  isn't exactly the reported one, or if the output doesn't null against the delayed input
+  as deeply as it should. Exits with 1 if any run failed.
+ */
+
+namespace
+{
+    struct Dimension
+    {
+        juce::String parameterID;
+        juce::StringArray values;
+    };
+
+    using Suite = std::vector<Dimension>;
+
+    void printUsage()
+    {
+        std::cout << "Usage: krush-latency [options]\n"
+                     "  -r, --rate <list>        sample rates in Hz, as a,b,c (default: 48000)\n"
+                     "  -b, --block <list>       host block sizes, as a,b,c (default: 32,100,512,4096)\n"
+                     "  -s, --set <id>=<value>   set a parameter on every run, can be repeated\n"
+                     "      --vary <id>=<list>   probe every value, as a,b,c or first..last; repeat\n"
+                     "                           for every combination (default: the built-in set)\n"
+                     "      --null <dB>          null depth a transparent path has to reach (default: -60)\n"
+                     "      --coloured-null <dB> the same for the oversamplers, whose filters\n"
+                     "                           colour the signal (default: -25)\n"
+                     "  -v, --verbose            print passing runs too\n";
+    }
+
+    Dimension parseDimension(const juce::String& assignment)
+    {
+        Dimension dimension;
+        dimension.parameterID = assignment.upToFirstOccurrenceOf("=", false, false).trim();
+        const auto values = assignment.fromFirstOccurrenceOf("=", false, false).trim();
+
+        if (values.contains(".."))
+        {
+            const auto first = values.upToFirstOccurrenceOf("..", false, false).getIntValue();
+            const auto last = values.fromFirstOccurrenceOf("..", false, false).getIntValue();
+            for (auto value = first; value <= last; ++value)
+                dimension.values.add(juce::String(value));
+        }
+        else
+        {
+            dimension.values.addTokens(values, ",", "");
+            dimension.values.trim();
+            dimension.values.removeEmptyStrings();
+        }
+
+        return dimension;
+    }
+
+    std::vector<Suite> getBuiltInSuites()
+    {
+        const auto orders = "order=" + juce::String(WindowSizes::minOrder) + ".." + juce::String(WindowSizes::maxOrder);
+        const auto sizes = "size=1.." + juce::String((int) WindowSizes::mixedRadix.size());
+        const auto overlaps = "overlap=" + juce::String(WindowSizes::minOverlapOrder) + ".." + juce::String(WindowSizes::maxOverlapOrder);
+        auto suite = [](std::initializer_list<const char*> dimensions)
+        {
+            Suite result;
+            for (auto* dimension : dimensions)
+                result.push_back(parseDimension(dimension));
+            return result;
+        };
+
+        return {
+            suite({orders.toRawUTF8(), "resolution=0..2"}),
+            suite({sizes.toRawUTF8(), "resolution=0..2"}),
+            suite({"batch=1", "order=8,10,13,15", "resolution=0..2"}),
+            suite({overlaps.toRawUTF8(), "resolution=0..2"}),
+            suite({"oversampling=1..3", "order=8,12"}),
+            suite({"stereo=1..2", "resolution=0..2"}),
+            suite({"mix=0,0.5"}),
+            suite({"bypass=1", "oversampling=0,2"})
+        };
+    }
+
+    // Every combination of the suite's values, merged over the fixed parameters.
+    std::vector<juce::StringPairArray> expand(const Suite& suite, const juce::StringPairArray& fixed)
+    {
+        std::vector<juce::StringPairArray> combinations{fixed};
+        for (const auto& dimension : suite)
+        {
+            std::vector<juce::StringPairArray> expanded;
+            for (const auto& combination : combinations)
+            {
+                for (const auto& value : dimension.values)
+                {
+                    auto parameters = combination;
+                    parameters.set(dimension.parameterID, value);
+                    expanded.push_back(parameters);
+                }
+            }
+            combinations = std::move(expanded);
+        }
+        return combinations;
+    }
+
+    // The oversamplers' filters aren't flat to the top of the sweep; everything else has
+    // to null as deeply as a plain delay.
+    bool isColoured(const juce::StringPairArray& parameters)
+    {
+        return parameters["oversampling"].isNotEmpty() && parameters["oversampling"] != "0"
+               && parameters["oversampling"] != "Off";
+    }
+
+    juce::String describe(const juce::StringPairArray& parameters, double sampleRate, int blockSize)
+    {
+        juce::StringArray parts;
+        for (const auto& parameterID : parameters.getAllKeys())
+            parts.add(parameterID + "=" + parameters[parameterID]);
+
+        parts.add(juce::String(sampleRate, 0) + " Hz");
+        parts.add("block " + juce::String(blockSize));
+        return parts.joinIntoString(" ");
+    }
+
+    juce::Array<double> parseList(const juce::String& list)
+    {
+        juce::StringArray tokens;
+        tokens.addTokens(list, ",", "");
+        tokens.trim();
+        tokens.removeEmptyStrings();
+
+        juce::Array<double> values;
+        for (const auto& token : tokens)
+            values.add(token.getDoubleValue());
+        return values;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::Array<double> sampleRates{48000.0};
+    juce::Array<double> blockSizes{32.0, 100.0, 512.0, 4096.0};
+    juce::StringPairArray fixed;
+    Suite varied;
+    auto transparentNull = -60.0;
+    auto colouredNull = -25.0;
+    auto verbose = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        const auto hasValue = i + 1 < argc;
+        auto value = [&] { return juce::String(argv[++i]); };
+
+        if ((arg == "-r" || arg == "--rate") && hasValue)
+            sampleRates = parseList(value());
+        else if ((arg == "-b" || arg == "--block") && hasValue)
+            blockSizes = parseList(value());
+        else if ((arg == "-s" || arg == "--set") && hasValue)
+        {
+            const auto assignment = value();
+            fixed.set(assignment.upToFirstOccurrenceOf("=", false, false).trim(),
+                      assignment.fromFirstOccurrenceOf("=", false, false).trim());
+        }
+        else if (arg == "--vary" && hasValue)
+            varied.push_back(parseDimension(value()));
+        else if (arg == "--null" && hasValue)
+            transparentNull = value().getDoubleValue();
+        else if (arg == "--coloured-null" && hasValue)
+            colouredNull = value().getDoubleValue();
+        else if (arg == "-v" || arg == "--verbose")
+            verbose = true;
+        else if (arg == "-h" || arg == "--help")
+        {
+            printUsage();
+            return 0;
+        }
+        else
+        {
+            std::cerr << "Unknown option " << arg << "\n";
+            printUsage();
+            return 2;
+        }
+    }
+
+    for (auto block : blockSizes)
+    {
+        if (block < 1.0 || block > 65536.0)
+        {
+            std::cerr << "Block sizes must be between 1 and 65536\n";
+            return 2;
+        }
+    }
+
+    const auto suites = varied.empty() ? getBuiltInSuites() : std::vector<Suite>{varied};
+    int numRuns = 0, numFailed = 0;
+
+    for (const auto& suite : suites)
+    {
+        for (const auto& parameters : expand(suite, fixed))
+        {
+            for (auto rate : sampleRates)
+            {
+                for (auto block : blockSizes)
+                {
+                    LatencyProbe::Settings settings;
+                    settings.sampleRate = rate;
+                    settings.blockSize = (int) block;
+                    settings.parameters = parameters;
+
+                    LatencyProbe probe(settings);
+                    LatencyProbe::Report report;
+                    const auto measured = probe.measure(report);
+                    const auto description = describe(parameters, rate, settings.blockSize);
+                    ++numRuns;
+
+                    if (measured.failed())
+                    {
+                        ++numFailed;
+                        std::cout << "ERROR " << description << ": " << measured.getErrorMessage() << "\n";
+                        continue;
+                    }
+
+                    const auto maxNull = isColoured(parameters) ? colouredNull : transparentNull;
+                    const auto passed = report.measuredLatency == report.reportedLatency && report.nullDepthDb <= maxNull;
+                    if (!passed)
+                        ++numFailed;
+
+                    if (!passed || verbose)
+                    {
+                        std::cout << (passed ? "pass  " : "FAIL  ") << description << ": reported " << report.reportedLatency
+                                  << ", measured " << report.measuredLatency << " (peak " << juce::String(report.impulsePeak, 3)
+                                  << "), null " << juce::String(report.nullDepthDb, 1) << " dB of " << juce::String(maxNull, 1)
+                                  << "\n";
+                    }
+                }
+            }
+        }
+    }
+
+    std::cout << numRuns - numFailed << " of " << numRuns << " runs passed\n";
+    return numFailed == 0 ? 0 : 1;
+}
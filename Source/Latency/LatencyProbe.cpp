@@ -0,0 +1,113 @@
+#include "LatencyProbe.h"
+
+LatencyProbe::LatencyProbe(const Settings& newSettings)
+    : settings(newSettings)
+{
+}
+
+juce::Result LatencyProbe::measure(Report& report)
+{
+    for (const auto& parameterID : settings.parameters.getAllKeys())
+    {
+        const auto applied = processor.setParameterFromText(parameterID, settings.parameters[parameterID]);
+        if (applied.failed())
+            return applied;
+    }
+
+    juce::AudioProcessor::BusesLayout buses;
+    buses.inputBuses.add(juce::AudioChannelSet::stereo());
+    buses.outputBuses.add(juce::AudioChannelSet::stereo());
+    if (!processor.setBusesLayout(buses))
+        return juce::Result::fail("Stereo layout not supported");
+
+    prepare();
+    report.reportedLatency = processor.getLatencySamples();
+
+    // Long enough for the impulse to come out even if the reported latency is far too short.
+    juce::AudioBuffer<float> impulse(numChannels, impulsePosition + 1);
+    impulse.clear();
+    for (int c = 0; c < numChannels; ++c)
+        impulse.setSample(c, impulsePosition, 1.0f);
+
+    const auto impulseOutput = process(impulse, 2 * report.reportedLatency + 65536);
+    const auto* channel = impulseOutput.getReadPointer(0);
+    const auto peak = std::max_element(channel, channel + impulseOutput.getNumSamples(),
+                                       [](float a, float b) { return std::abs(a) < std::abs(b); });
+    report.measuredLatency = (int) (peak - channel) - impulsePosition;
+    report.impulsePeak = *peak;
+
+    prepare();
+    const auto sweep = createSweep();
+    const auto sweepOutput = process(sweep, report.reportedLatency);
+
+    double error = 0.0, reference = 0.0;
+    for (int c = 0; c < numChannels; ++c)
+    {
+        const auto* dry = sweep.getReadPointer(c);
+        const auto* wet = sweepOutput.getReadPointer(c) + report.reportedLatency;
+        for (int i = 0; i < sweep.getNumSamples(); ++i)
+        {
+            error += (double) (wet[i] - dry[i]) * (wet[i] - dry[i]);
+            reference += (double) dry[i] * dry[i];
+        }
+    }
+
+    report.nullDepthDb = 10.0 * std::log10(juce::jmax(error, 1.0e-30) / reference);
+    return juce::Result::ok();
+}
+
+void LatencyProbe::prepare()
+{
+    processor.setRateAndBufferSizeDetails(settings.sampleRate, settings.blockSize);
+    processor.prepareToPlay(settings.sampleRate, settings.blockSize);
+    block.setSize(numChannels, settings.blockSize);
+}
+
+juce::AudioBuffer<float> LatencyProbe::process(const juce::AudioBuffer<float>& input, int extraSamples)
+{
+    const auto length = input.getNumSamples() + extraSamples;
+    juce::AudioBuffer<float> output(numChannels, length);
+
+    for (int start = 0; start < length; start += settings.blockSize)
+    {
+        const auto numSamples = juce::jmin(settings.blockSize, length - start);
+        block.setSize(numChannels, numSamples, false, false, true);
+        block.clear();
+
+        const auto numInput = juce::jlimit(0, numSamples, input.getNumSamples() - start);
+        for (int c = 0; c < numChannels; ++c)
+            block.copyFrom(c, 0, input, c, start, numInput);
+
+        processor.processBlock(block, midi);
+
+        for (int c = 0; c < numChannels; ++c)
+            output.copyFrom(c, start, block, c, 0, numSamples);
+    }
+
+    return output;
+}
+
+juce::AudioBuffer<float> LatencyProbe::createSweep() const
+{
+    // An exponential sweep up to where the oversamplers' half-band filters start rolling
+    // off, faded in and out. The right channel is a scaled, inverted copy, so mid/side has
+    // a side to carry.
+    const auto length = juce::roundToInt(sweepSeconds * settings.sampleRate);
+    const auto endFrequency = 0.4 * settings.sampleRate;
+    const auto rate = std::log(endFrequency / sweepStartFrequency) / sweepSeconds;
+    const auto fadeLength = juce::roundToInt(0.01 * settings.sampleRate);
+
+    juce::AudioBuffer<float> sweep(numChannels, length);
+    for (int i = 0; i < length; ++i)
+    {
+        const auto time = i / settings.sampleRate;
+        const auto phase = juce::MathConstants<double>::twoPi * sweepStartFrequency * (std::exp(rate * time) - 1.0) / rate;
+        const auto fade = juce::jmin(1.0, juce::jmin(i, length - 1 - i) / (double) fadeLength);
+        const auto sample = (float) (0.5 * fade * std::sin(phase));
+
+        sweep.setSample(0, i, sample);
+        sweep.setSample(1, i, -0.6f * sample);
+    }
+
+    return sweep;
+}
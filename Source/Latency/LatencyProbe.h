@@ -0,0 +1,55 @@
+#pragma once
+#include "../PluginProcessor.h"
+
+/*
+  Measures what AudioPluginAudioProcessor does to timing against what it reports. For
+  one set of parameters, sample rate and host block size it prepares a fresh processor,
+  sends an impulse through to find the actual delay, then a log sweep to find how deep
+  the output nulls against the input delayed by the reported latency.
+
+  At the default settings the spectral chain changes nothing and the windows overlap-add
+  back to one, so anything that doesn't null is either a latency that's off or a part of
+  the path that colours the signal, which should only be the oversamplers' filters.
+ */
+class LatencyProbe
+{
+public:
+    struct Settings
+    {
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        // Parameter ID to value text, as AudioPluginAudioProcessor::setParameterFromText takes them.
+        juce::StringPairArray parameters;
+    };
+
+    struct Report
+    {
+        int reportedLatency = 0;
+        int measuredLatency = 0;
+        float impulsePeak = 0.0f;
+        double nullDepthDb = 0.0;
+    };
+
+    explicit LatencyProbe(const Settings& newSettings);
+
+    juce::Result measure(Report& report);
+
+private:
+    static constexpr int numChannels = 2;
+    static constexpr int impulsePosition = 1000;
+    static constexpr double sweepSeconds = 2.0;
+    static constexpr double sweepStartFrequency = 20.0;
+
+    void prepare();
+    // Runs input through the processor in host blocks, with silence after it, for
+    // input.getNumSamples() + extraSamples samples of output.
+    juce::AudioBuffer<float> process(const juce::AudioBuffer<float>& input, int extraSamples);
+    juce::AudioBuffer<float> createSweep() const;
+
+    Settings settings;
+    AudioPluginAudioProcessor processor;
+    juce::AudioBuffer<float> block;
+    juce::MidiBuffer midi;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LatencyProbe)
+};
@@ -0,0 +1,205 @@
+#include "KrushDSP.h"
+
+KrushDSP::KrushDSP()
+{
+    for (int p = 0; p < numParameters; ++p)
+        values[(size_t) p] = getRange(static_cast<Parameter>(p)).getStart();
+
+    // Everything defaults to the bottom of its range except these.
+    values[(size_t) Parameter::highLimit] = SpectralChain::maxFrequency;
+    values[(size_t) Parameter::tilt] = 0.0f;
+    values[(size_t) Parameter::mix] = 1.0f;
+    values[(size_t) Parameter::gain] = 0.0f;
+}
+
+juce::Result KrushDSP::configure(const Config& newConfig)
+{
+    if (newConfig.sampleRate <= 0.0
+        || !juce::isPositiveAndNotGreaterThan(newConfig.numChannels, maxChannels)
+        || newConfig.maxBlockSize <= 0
+        || !isSupportedFFTSize(newConfig.fftSize)
+        || newConfig.overlapOrder < WindowSizes::minOverlapOrder || newConfig.overlapOrder > WindowSizes::maxOverlapOrder
+        || !juce::isPositiveAndNotGreaterThan((int) newConfig.mode, (int) SpectralEngineConfig::Mode::transientAdaptive)
+        || !juce::isPositiveAndNotGreaterThan(newConfig.stereo, 2)
+        || !juce::isPositiveAndNotGreaterThan(newConfig.oversampling, overSampleGain::maxFactorIndex))
+        return juce::Result::fail("Invalid config");
+
+    // Mid Only transforms the mid channel and only delays the side.
+    SpectralEngineConfig engineConfig;
+    engineConfig.fftSize = newConfig.fftSize;
+    engineConfig.overlapOrder = newConfig.overlapOrder;
+    engineConfig.numChannels = newConfig.numChannels;
+    engineConfig.numSpectralChannels = newConfig.numChannels == 2 && newConfig.stereo == 2 ? 1 : newConfig.numChannels;
+    engineConfig.mode = newConfig.mode;
+    engineConfig.sampleRate = newConfig.sampleRate;
+
+    // Everything is built on the side and only moved in once it all exists, so running
+    // out of memory leaves the previous configuration as it was.
+    auto newEngine = std::make_unique<SpectralEngine>(engineConfig);
+    // Smear can be turned up from the audio thread, and there's no other thread to
+    // allocate its history on later.
+    newEngine->getChain().getFreeze().allocateHistory();
+    for (int p = 0; p < numSpectralParameters; ++p)
+        applySpectralParameter(newEngine->getChain(), static_cast<Parameter>(p));
+
+    SpectralPath newPath;
+    newPath.prepare(newConfig.numChannels, newConfig.maxBlockSize);
+    juce::AudioBuffer<float> newPlanarInput(newConfig.numChannels, newConfig.maxBlockSize);
+    juce::AudioBuffer<float> newPlanarOutput(newConfig.numChannels, newConfig.maxBlockSize);
+
+    overSampleGain newGain;
+    newGain.prepare(newConfig.numChannels, newConfig.maxBlockSize);
+    newGain.setFactorIndex(newConfig.oversampling);
+
+    config = newConfig;
+    engine = std::move(newEngine);
+    spectralPath = std::move(newPath);
+    planarInput = std::move(newPlanarInput);
+    planarOutput = std::move(newPlanarOutput);
+    osg = std::move(newGain);
+
+    reset();
+    return juce::Result::ok();
+}
+
+bool KrushDSP::setParameter(Parameter parameter, float value)
+{
+    // Clamping would pass a NaN straight through.
+    if (!std::isfinite(value))
+        return false;
+
+    values[(size_t) parameter] = getRange(parameter).clipValue(value);
+
+    if ((int) parameter < numSpectralParameters && engine != nullptr)
+        applySpectralParameter(engine->getChain(), parameter);
+
+    return true;
+}
+
+void KrushDSP::reset()
+{
+    if (engine == nullptr)
+        return;
+
+    engine->reset();
+    osg.reset();
+}
+
+int KrushDSP::getLatencyInSamples() const
+{
+    return engine != nullptr ? engine->getLatencyInSamples() + osg.getLatencyInSamples() : -1;
+}
+
+void KrushDSP::process(const float* const* input, float* const* output, int numSamples)
+{
+    jassert(engine != nullptr);
+    juce::ScopedNoDenormals noDenormals;
+
+    const float* blockInput[maxChannels];
+    float* blockOutput[maxChannels];
+
+    for (int start = 0; start < numSamples; start += config.maxBlockSize)
+    {
+        for (int c = 0; c < config.numChannels; ++c)
+        {
+            blockInput[c] = input[c] + start;
+            blockOutput[c] = output[c] + start;
+        }
+
+        processBlock(blockInput, blockOutput, juce::jmin(config.maxBlockSize, numSamples - start));
+    }
+}
+
+void KrushDSP::processInterleaved(const float* input, float* output, int numFrames)
+{
+    jassert(engine != nullptr);
+    juce::ScopedNoDenormals noDenormals;
+
+    const auto numChannels = config.numChannels;
+
+    for (int start = 0; start < numFrames; start += config.maxBlockSize)
+    {
+        const auto numSamples = juce::jmin(config.maxBlockSize, numFrames - start);
+        const float* in = input + start * numChannels;
+        float* out = output + start * numChannels;
+
+        for (int c = 0; c < numChannels; ++c)
+        {
+            auto* planar = planarInput.getWritePointer(c);
+            for (int i = 0; i < numSamples; ++i)
+                planar[i] = in[i * numChannels + c];
+        }
+
+        processBlock(planarInput.getArrayOfReadPointers(), planarOutput.getArrayOfWritePointers(), numSamples);
+
+        for (int c = 0; c < numChannels; ++c)
+        {
+            const auto* planar = planarOutput.getReadPointer(c);
+            for (int i = 0; i < numSamples; ++i)
+                out[i * numChannels + c] = planar[i];
+        }
+    }
+}
+
+bool KrushDSP::isSupportedFFTSize(int fftSize)
+{
+    if (juce::isPowerOfTwo(fftSize))
+        return fftSize >= (1 << WindowSizes::minOrder) && fftSize <= (1 << WindowSizes::maxOrder);
+
+    return std::find(WindowSizes::mixedRadix.begin(), WindowSizes::mixedRadix.end(), fftSize) != WindowSizes::mixedRadix.end();
+}
+
+juce::Range<float> KrushDSP::getRange(Parameter parameter)
+{
+    switch (parameter)
+    {
+        case Parameter::crush: return {1.0f, (float) SpectralCrush::maxCrush};
+        case Parameter::grouping: return {0.0f, 2.0f};
+        case Parameter::smear: return {0.0f, (float) SpectralFreeze::maxSmearSeconds * 1000.0f};
+        case Parameter::gate: return {SpectralGate::offThreshold, 0.0f};
+        case Parameter::tilt: return {-6.0f, 6.0f};
+        case Parameter::lowLimit:
+        case Parameter::highLimit: return {SpectralChain::minFrequency, SpectralChain::maxFrequency};
+        case Parameter::gain: return {-24.0f, 24.0f};
+        case Parameter::freeze:
+        case Parameter::blur:
+        case Parameter::mix:
+        case Parameter::softClip:
+        case Parameter::bypass:
+        case Parameter::numParameters: break;
+    }
+
+    return {0.0f, 1.0f};
+}
+
+void KrushDSP::applySpectralParameter(SpectralChain& chain, Parameter parameter)
+{
+    auto value = values[(size_t) parameter];
+
+    // Smear is set in ms like the plugin's, but the chain takes seconds.
+    if (parameter == Parameter::smear)
+        value *= 0.001f;
+
+    chain.setParameter(static_cast<SpectralChain::Parameter>(parameter), value);
+}
+
+void KrushDSP::processBlock(const float* const* input, float* const* output, int numSamples)
+{
+    for (int c = 0; c < config.numChannels; ++c)
+        if (output[c] != input[c])
+            juce::FloatVectorOperations::copy(output[c], input[c], numSamples);
+
+    auto& chain = engine->getChain();
+    SpectralPath::Settings settings;
+    settings.midSide = config.stereo > 0;
+    settings.spectralBypassed = !chain.hasBinsInRange();
+    settings.bypassed = values[(size_t) Parameter::bypass] >= 0.5f;
+    settings.wetGain = values[(size_t) Parameter::mix];
+
+    spectralPath.process(*engine, output, numSamples, settings, [&chain](SpectralFrame& frame) { chain.process(frame); });
+
+    // Bypass passes the dry signal through the gain stage at unity so the latency doesn't change.
+    juce::dsp::AudioBlock<float> block(output, (size_t) config.numChannels, (size_t) numSamples);
+    osg.process(block, settings.bypassed ? 0.0f : values[(size_t) Parameter::gain],
+                !settings.bypassed && values[(size_t) Parameter::softClip] >= 0.5f);
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "../DSP/SpectralEngine.h"
+#include "../DSP/SpectralPath.h"
+#include "../DSP/WindowSizes.h"
+#include "../Utility/overSampleGain.h"
+
+/*
+  The Krush signal path on its own: the spectral engine and its chain inside the same
+  SpectralPath AudioPluginAudioProcessor::processBlock runs, then the oversampled gain
+  stage. There are no parameter objects or host to answer to, so it only needs juce_dsp
+  and what that depends on.
+
+  configure() is the only call that allocates. setParameter(), process() and reset() can
+  run on any one thread after it, with no allocation or locks. krush_dsp.h wraps this as
+  a C API.
+ */
+class KrushDSP
+{
+public:
+    static constexpr int maxChannels = 16;
+
+    struct Config
+    {
+        double sampleRate = 44100.0;
+        int numChannels = 2;
+        int maxBlockSize = 512;
+        int fftSize = 1024;
+        // Every band hops by its size over 2^overlapOrder, as the plugin's "overlap".
+        int overlapOrder = 2;
+        SpectralEngineConfig::Mode mode = SpectralEngineConfig::Mode::single;
+        // 0 L/R, 1 M/S, 2 Mid Only, as the plugin's "stereo" choice.
+        int stereo = 0;
+        // 0 for none, then 2x, 4x and 8x.
+        int oversampling = 0;
+    };
+
+    // The spectral ones come first, in SpectralChain::Parameter's order.
+    enum class Parameter { crush, grouping, freeze, smear, blur, gate, tilt, lowLimit, highLimit,
+                           mix, gain, softClip, bypass, numParameters };
+
+    KrushDSP();
+
+    juce::Result configure(const Config& newConfig);
+    bool isConfigured() const { return engine != nullptr; }
+    const Config& getConfig() const { return config; }
+
+    // In the plugin's units (see krush_dsp.h), clamped to the range. Kept across
+    // configure(). Returns false and keeps the old value if the new one isn't finite.
+    bool setParameter(Parameter parameter, float value);
+    float getParameter(Parameter parameter) const { return values[(size_t) parameter]; }
+
+    void reset();
+    int getLatencyInSamples() const;
+
+    // Any number of samples; input and output may be the same channels.
+    void process(const float* const* input, float* const* output, int numSamples);
+    void processInterleaved(const float* input, float* output, int numFrames);
+
+private:
+    static constexpr int numSpectralParameters = (int) Parameter::mix;
+    static constexpr int numParameters = (int) Parameter::numParameters;
+
+    static bool isSupportedFFTSize(int fftSize);
+    static juce::Range<float> getRange(Parameter parameter);
+    void applySpectralParameter(SpectralChain& chain, Parameter parameter);
+    void processBlock(const float* const* input, float* const* output, int numSamples);
+
+    Config config;
+    std::unique_ptr<SpectralEngine> engine;
+    overSampleGain osg;
+    SpectralPath spectralPath;
+    juce::AudioBuffer<float> planarInput, planarOutput;
+    std::array<float, numParameters> values{};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KrushDSP)
+};
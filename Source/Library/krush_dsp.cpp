@@ -0,0 +1,109 @@
+#include "krush_dsp.h"
+#include "KrushDSP.h"
+#include <new>
+
+struct krush_dsp
+{
+    KrushDSP dsp;
+};
+
+void krush_default_config(krush_config* config)
+{
+    if (config == nullptr)
+        return;
+
+    const KrushDSP::Config defaults;
+    config->sample_rate = defaults.sampleRate;
+    config->num_channels = defaults.numChannels;
+    config->max_block_size = defaults.maxBlockSize;
+    config->fft_size = defaults.fftSize;
+    config->overlap_order = defaults.overlapOrder;
+    config->resolution = (int) defaults.mode;
+    config->stereo = defaults.stereo;
+    config->oversampling = defaults.oversampling;
+}
+
+krush_dsp* krush_create(void)
+{
+    return new (std::nothrow) krush_dsp;
+}
+
+void krush_destroy(krush_dsp* dsp)
+{
+    delete dsp;
+}
+
+krush_result krush_configure(krush_dsp* dsp, const krush_config* config)
+{
+    if (dsp == nullptr || config == nullptr)
+        return KRUSH_ERROR_INVALID_ARGUMENT;
+
+    KrushDSP::Config newConfig;
+    newConfig.sampleRate = config->sample_rate;
+    newConfig.numChannels = config->num_channels;
+    newConfig.maxBlockSize = config->max_block_size;
+    newConfig.fftSize = config->fft_size;
+    newConfig.overlapOrder = config->overlap_order;
+    newConfig.mode = static_cast<SpectralEngineConfig::Mode>(config->resolution);
+    newConfig.stereo = config->stereo;
+    newConfig.oversampling = config->oversampling;
+
+    // Nothing may throw across the C boundary, and configure() is the only call that can.
+    try
+    {
+        return dsp->dsp.configure(newConfig).wasOk() ? KRUSH_OK : KRUSH_ERROR_INVALID_ARGUMENT;
+    }
+    catch (const std::bad_alloc&)
+    {
+        return KRUSH_ERROR_OUT_OF_MEMORY;
+    }
+}
+
+krush_result krush_set_parameter(krush_dsp* dsp, krush_parameter parameter, float value)
+{
+    if (dsp == nullptr || !juce::isPositiveAndBelow((int) parameter, (int) KrushDSP::Parameter::numParameters))
+        return KRUSH_ERROR_INVALID_ARGUMENT;
+
+    return dsp->dsp.setParameter(static_cast<KrushDSP::Parameter>(parameter), value) ? KRUSH_OK : KRUSH_ERROR_INVALID_ARGUMENT;
+}
+
+krush_result krush_reset(krush_dsp* dsp)
+{
+    if (dsp == nullptr)
+        return KRUSH_ERROR_INVALID_ARGUMENT;
+
+    if (!dsp->dsp.isConfigured())
+        return KRUSH_ERROR_NOT_CONFIGURED;
+
+    dsp->dsp.reset();
+    return KRUSH_OK;
+}
+
+int krush_get_latency(const krush_dsp* dsp)
+{
+    return dsp != nullptr ? dsp->dsp.getLatencyInSamples() : -1;
+}
+
+krush_result krush_process_planar(krush_dsp* dsp, const float* const* input, float* const* output, int num_samples)
+{
+    if (dsp == nullptr || input == nullptr || output == nullptr || num_samples < 0)
+        return KRUSH_ERROR_INVALID_ARGUMENT;
+
+    if (!dsp->dsp.isConfigured())
+        return KRUSH_ERROR_NOT_CONFIGURED;
+
+    dsp->dsp.process(input, output, num_samples);
+    return KRUSH_OK;
+}
+
+krush_result krush_process_interleaved(krush_dsp* dsp, const float* input, float* output, int num_frames)
+{
+    if (dsp == nullptr || input == nullptr || output == nullptr || num_frames < 0)
+        return KRUSH_ERROR_INVALID_ARGUMENT;
+
+    if (!dsp->dsp.isConfigured())
+        return KRUSH_ERROR_NOT_CONFIGURED;
+
+    dsp->dsp.processInterleaved(input, output, num_frames);
+    return KRUSH_OK;
+}
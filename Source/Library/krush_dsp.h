@@ -0,0 +1,106 @@
+#ifndef KRUSH_DSP_H
+#define KRUSH_DSP_H
+
+/*
+  C API for the KrushDSP library: the Krush signal path without the plugin, its
+  parameters or its GUI.
+
+  krush_configure() allocates everything; krush_set_parameter(), krush_process_*() and
+  krush_reset() never allocate or lock, and work on caller-provided buffers. One
+  instance must only be used from one thread at a time; separate instances are
+  independent.
+
+  The output is delayed by krush_get_latency() samples, which changes only on
+  krush_configure().
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct krush_dsp krush_dsp;
+
+typedef enum krush_result
+{
+    KRUSH_OK = 0,
+    KRUSH_ERROR_INVALID_ARGUMENT = -1,
+    KRUSH_ERROR_NOT_CONFIGURED = -2,
+    KRUSH_ERROR_OUT_OF_MEMORY = -3
+} krush_result;
+
+typedef enum krush_resolution
+{
+    KRUSH_RESOLUTION_SINGLE = 0,
+    KRUSH_RESOLUTION_MULTI = 1,
+    KRUSH_RESOLUTION_ADAPTIVE = 2
+} krush_resolution;
+
+/* Mid/side modes only apply to two channels. */
+typedef enum krush_stereo
+{
+    KRUSH_STEREO_LEFT_RIGHT = 0,
+    KRUSH_STEREO_MID_SIDE = 1,
+    KRUSH_STEREO_MID_ONLY = 2
+} krush_stereo;
+
+typedef struct krush_config
+{
+    double sample_rate;
+    int num_channels;       /* 1 to 16 */
+    int max_block_size;     /* longer blocks are processed in pieces */
+    int fft_size;           /* 256 to 32768 as a power of two, or 384, 640, 768, 1280, 1536, 2400, 3072, 6000 */
+    int overlap_order;      /* 2 to 5: frames hop by fft_size / 2^overlap_order */
+    int resolution;         /* krush_resolution */
+    int stereo;             /* krush_stereo */
+    int oversampling;       /* gain stage: 0 off, 1 2x, 2 4x, 3 8x */
+} krush_config;
+
+/* Same units and ranges as the plugin's parameters. */
+typedef enum krush_parameter
+{
+    KRUSH_PARAMETER_CRUSH = 0,      /* 1 to 25 */
+    KRUSH_PARAMETER_GROUPING,       /* 0 linear, 1 log, 2 bark */
+    KRUSH_PARAMETER_FREEZE,         /* 0 or 1 */
+    KRUSH_PARAMETER_SMEAR,          /* ms, 0 to 2000 */
+    KRUSH_PARAMETER_BLUR,           /* 0 to 1 */
+    KRUSH_PARAMETER_GATE,           /* dBFS, -100 (off) to 0 */
+    KRUSH_PARAMETER_TILT,           /* dB per octave, -6 to 6 */
+    KRUSH_PARAMETER_LOW_LIMIT,      /* Hz, 20 to 20000 */
+    KRUSH_PARAMETER_HIGH_LIMIT,     /* Hz, 20 to 20000 */
+    KRUSH_PARAMETER_MIX,            /* 0 to 1 */
+    KRUSH_PARAMETER_GAIN,           /* dB, -24 to 24 */
+    KRUSH_PARAMETER_SOFT_CLIP,      /* 0 or 1 */
+    KRUSH_PARAMETER_BYPASS          /* 0 or 1 */
+} krush_parameter;
+
+/* Fills in the plugin's defaults for 44.1 kHz stereo in blocks of 512. */
+void krush_default_config(krush_config* config);
+
+/* NULL if out of memory. The instance needs krush_configure() before it can process. */
+krush_dsp* krush_create(void);
+void krush_destroy(krush_dsp* dsp);
+
+/* Builds the signal path for the config and resets it. Parameters set before are kept. */
+krush_result krush_configure(krush_dsp* dsp, const krush_config* config);
+
+/* Takes effect from the next block. Values are clamped to their range; a NaN or infinity
+   is rejected with KRUSH_ERROR_INVALID_ARGUMENT and leaves the parameter as it was. */
+krush_result krush_set_parameter(krush_dsp* dsp, krush_parameter parameter, float value);
+
+/* Clears the signal path's state as if nothing had been processed. */
+krush_result krush_reset(krush_dsp* dsp);
+
+/* In samples at the configured rate, or -1 if not configured. */
+int krush_get_latency(const krush_dsp* dsp);
+
+/* One pointer per channel. input and output may be the same buffers. */
+krush_result krush_process_planar(krush_dsp* dsp, const float* const* input, float* const* output, int num_samples);
+
+/* num_frames frames of num_channels samples each. input and output may be the same buffer. */
+krush_result krush_process_interleaved(krush_dsp* dsp, const float* input, float* output, int num_frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,244 @@
+#include "../Utility/SharedMetrics.h"
+#include <iostream>
+#include <map>
+#include <thread>
+
+/*
+  krush-top: a top-style view of every Krush instance on this machine, read from the
+  shared memory each one publishes to (see SharedMetrics). Rates, CPU and the callback
+  distribution are taken over the refresh interval; CPU is the share of one core the
+  instance's callbacks took.
+
+    krush-top [options]
+
+  Instances only publish while KRUSH_METRICS is set, so set it to 1 in the host's
+  environment before starting it.
+ */
+
+namespace
+{
+    constexpr juce::int64 stoppedAfterMilliseconds = 1000;
+
+    struct Reading
+    {
+        juce::uint64 numCallbacks = 0, numSamples = 0, numDeadlineMisses = 0;
+        double totalMicroseconds = 0.0;
+        std::array<juce::uint64, SharedMetrics::numBuckets> buckets{};
+    };
+
+    struct Instance
+    {
+        std::unique_ptr<SharedMetricsSegment> segment;
+        Reading previous;
+    };
+
+    Reading read(const SharedMetrics& metrics)
+    {
+        Reading reading;
+        reading.numCallbacks = metrics.numCallbacks.load(std::memory_order_relaxed);
+        reading.numSamples = metrics.numSamples.load(std::memory_order_relaxed);
+        reading.numDeadlineMisses = metrics.numDeadlineMisses.load(std::memory_order_relaxed);
+        reading.totalMicroseconds = metrics.totalMicroseconds.load(std::memory_order_relaxed);
+        for (size_t b = 0; b < reading.buckets.size(); ++b)
+            reading.buckets[b] = metrics.buckets[b].load(std::memory_order_relaxed);
+        return reading;
+    }
+
+    // The upper limit of the bucket the given fraction of callbacks fall under.
+    double getPercentileLimit(const Reading& now, const Reading& before, double fraction)
+    {
+        const auto count = now.numCallbacks - before.numCallbacks;
+        if (count == 0)
+            return 0.0;
+
+        juce::uint64 cumulative = 0;
+        for (int b = 0; b < SharedMetrics::numBuckets; ++b)
+        {
+            cumulative += now.buckets[(size_t) b] - before.buckets[(size_t) b];
+            if ((double) cumulative >= fraction * (double) count)
+                return SharedMetrics::getBucketLimitMicroseconds(b);
+        }
+        return SharedMetrics::getBucketLimitMicroseconds(SharedMetrics::numBuckets - 1);
+    }
+
+    juce::String getState(const SharedMetrics& metrics)
+    {
+        const auto sinceLast = juce::Time::currentTimeMillis() - metrics.lastCallbackMilliseconds.load(std::memory_order_relaxed);
+        if (metrics.numCallbacks.load(std::memory_order_relaxed) == 0 || sinceLast > stoppedAfterMilliseconds)
+            return "stopped";
+        if (metrics.bypassed.load(std::memory_order_relaxed) != 0)
+            return "bypassed";
+        if (metrics.inputSilent.load(std::memory_order_relaxed) != 0)
+            return "silent";
+        return "active";
+    }
+
+    juce::String getEngineText(const SharedMetrics& metrics)
+    {
+        static const juce::StringArray resolutions{"single", "multi", "adaptive"};
+        auto text = juce::String(metrics.fftSize.load(std::memory_order_relaxed)) + "/"
+                    + juce::String(1 << metrics.overlapOrder.load(std::memory_order_relaxed)) + " "
+                    + resolutions[metrics.resolution.load(std::memory_order_relaxed)];
+
+        if (metrics.batched.load(std::memory_order_relaxed) != 0)
+            text << " batch";
+        if (const auto factor = metrics.oversampling.load(std::memory_order_relaxed); factor > 0)
+            text << " " << (1 << factor) << "x";
+        return text;
+    }
+
+    juce::String pad(const juce::String& text, int width, bool right = true)
+    {
+        return right ? text.paddedLeft(' ', width) : text.paddedRight(' ', width);
+    }
+
+    void printUsage()
+    {
+        std::cout << "Usage: krush-top [options]\n"
+                     "  -i, --interval <s>   seconds between refreshes (default: 1)\n"
+                     "  -n, --iterations <n> refresh this many times and exit (default: until stopped)\n"
+                     "  -p, --pid <pid>      only show this process, can be repeated\n"
+                     "      --clean          remove segments left behind by processes that died, and exit\n"
+                     "Instances only publish their metrics while KRUSH_METRICS=1 is set in the host's environment.\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    auto interval = 1.0;
+    auto iterations = -1;
+    auto clean = false;
+    juce::Array<int> processIDs;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        const auto hasValue = i + 1 < argc;
+        auto value = [&] { return juce::String(argv[++i]); };
+
+        if ((arg == "-i" || arg == "--interval") && hasValue)
+            interval = juce::jmax(0.1, value().getDoubleValue());
+        else if ((arg == "-n" || arg == "--iterations") && hasValue)
+            iterations = juce::jmax(1, value().getIntValue());
+        else if ((arg == "-p" || arg == "--pid") && hasValue)
+            processIDs.add(value().getIntValue());
+        else if (arg == "--clean")
+            clean = true;
+        else if (arg == "-h" || arg == "--help")
+        {
+            printUsage();
+            return 0;
+        }
+        else
+        {
+            std::cerr << "Unknown option " << arg << "\n";
+            printUsage();
+            return 2;
+        }
+    }
+
+    if (clean)
+    {
+        auto numRemoved = 0;
+        for (const auto& name : SharedMetricsSegment::findAll())
+        {
+            auto segment = SharedMetricsSegment::open(name);
+            if (segment != nullptr && segment->isOwnerAlive())
+                continue;
+
+            SharedMetricsSegment::remove(name);
+            ++numRemoved;
+        }
+
+        std::cout << numRemoved << " stale segments removed\n";
+        return 0;
+    }
+
+    std::map<juce::String, Instance> instances;
+    auto lastRefresh = juce::Time::getHighResolutionTicks();
+
+    for (int iteration = 0; iterations < 0 || iteration <= iterations; ++iteration)
+    {
+        const auto names = SharedMetricsSegment::findAll();
+        for (auto it = instances.begin(); it != instances.end();)
+            it = names.contains(it->first) ? std::next(it) : instances.erase(it);
+
+        for (const auto& name : names)
+        {
+            if (instances.count(name) > 0)
+                continue;
+
+            auto segment = SharedMetricsSegment::open(name);
+            if (segment == nullptr)
+                continue;
+
+            const auto processID = segment->getMetrics().processID;
+            if (!processIDs.isEmpty() && !processIDs.contains(processID))
+                continue;
+
+            Instance instance;
+            instance.previous = read(segment->getMetrics());
+            instance.segment = std::move(segment);
+            instances.emplace(name, std::move(instance));
+        }
+
+        // The first pass only takes the readings the next one is measured from.
+        if (iteration > 0)
+        {
+            const auto now = juce::Time::getHighResolutionTicks();
+            const auto elapsedMicroseconds = 1.0e6 * juce::Time::highResolutionTicksToSeconds(now - lastRefresh);
+            lastRefresh = now;
+
+            if (iterations < 0)
+                std::cout << "\x1b[H\x1b[2J";
+
+            std::cout << pad("PID", 8) << pad("INST", 5) << "  " << pad("ENGINE", 22, false) << pad("CB/S", 7)
+                      << pad("CPU%", 7) << pad("MEAN us", 9) << pad("P99 us", 9) << pad("MAX us", 9) << pad("MISSED", 8)
+                      << pad("MEM MB", 8) << "  STATE\n";
+
+            auto totalCPU = 0.0;
+            double totalMemory = 0.0;
+            juce::uint64 totalMisses = 0;
+            auto numActive = 0;
+
+            for (auto& [name, instance] : instances)
+            {
+                const auto& metrics = instance.segment->getMetrics();
+                const auto reading = read(metrics);
+                const auto& before = instance.previous;
+
+                const auto callbacks = reading.numCallbacks - before.numCallbacks;
+                const auto busy = reading.totalMicroseconds - before.totalMicroseconds;
+                const auto misses = reading.numDeadlineMisses - before.numDeadlineMisses;
+                const auto cpu = 100.0 * busy / elapsedMicroseconds;
+                const auto memory = (double) metrics.memoryBytes.load(std::memory_order_relaxed) / (1024.0 * 1024.0);
+                const auto state = instance.segment->isOwnerAlive() ? getState(metrics) : juce::String("dead");
+
+                std::cout << pad(juce::String(metrics.processID), 8) << pad(juce::String(metrics.instanceID), 5) << "  "
+                          << pad(getEngineText(metrics), 22, false)
+                          << pad(juce::String(1.0e6 * (double) callbacks / elapsedMicroseconds, 0), 7)
+                          << pad(juce::String(cpu, 1), 7)
+                          << pad(juce::String(callbacks > 0 ? busy / (double) callbacks : 0.0, 1), 9)
+                          << pad("<" + juce::String(getPercentileLimit(reading, before, 0.99), 0), 9)
+                          << pad(juce::String(metrics.maxMicroseconds.load(std::memory_order_relaxed), 0), 9)
+                          << pad(juce::String((juce::int64) misses), 8)
+                          << pad(juce::String(memory, 1), 8) << "  " << state << "\n";
+
+                totalCPU += cpu;
+                totalMemory += memory;
+                totalMisses += misses;
+                numActive += state == "active" ? 1 : 0;
+                instance.previous = reading;
+            }
+
+            std::cout << instances.size() << " instances, " << numActive << " active, " << juce::String(totalCPU, 1)
+                      << "% of a core, " << (juce::int64) totalMisses << " deadlines missed, "
+                      << juce::String(totalMemory, 1) << " MB\n" << std::flush;
+        }
+
+        if (iterations < 0 || iteration < iterations)
+            std::this_thread::sleep_for(std::chrono::duration<double>(interval));
+    }
+
+    return 0;
+}
@@ -23,6 +23,17 @@ AudioPluginAudioProcessorEditor::AudioPluginAudioProcessorEditor (AudioPluginAud
     addAndMakeVisible(showAnimator);
     addAndMakeVisible(*crush);
     addAndMakeVisible(animator);
+
+   #if KRUSH_INSTRUMENTATION
+    showPerformance.setButtonText("CPU");
+    showPerformance.onClick = [this]()
+    {
+        performanceOverlay.setVisible(showPerformance.getToggleState());
+    };
+
+    addAndMakeVisible(showPerformance);
+    addChildComponent(performanceOverlay);
+   #endif
     
     setSize (500, 500);
 
@@ -71,6 +82,11 @@ void AudioPluginAudioProcessorEditor::resized()
     morePlugins.removeFromTop(morePlugins.getHeight() * .95);
     morePlugins.removeFromRight(morePlugins.getWidth() * .8);
     gumroad.setBounds(morePlugins);
+
+   #if KRUSH_INSTRUMENTATION
+    showPerformance.setBounds(animatorButtonBounds.withX(animatorButtonBounds.getX() - animatorButtonBounds.getWidth()));
+    performanceOverlay.setBounds(bitDepthBounds);
+   #endif
 }   
 
 void AudioPluginAudioProcessorEditor::updateRSWL(juce::AudioProcessorValueTreeState& apvts)
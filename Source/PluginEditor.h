@@ -6,6 +6,7 @@
 #include "GUI/KitikLookAndFeel.h"
 #include "GUI/RotarySliderWithLabels.h"
 #include "GUI/Animator.h"
+#include "GUI/PerformanceOverlay.h"
 
 //==============================================================================
 class AudioPluginAudioProcessorEditor final : public juce::AudioProcessorEditor
@@ -37,6 +38,11 @@ private:
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> bitRateAT;
     juce::AudioProcessorValueTreeState::ButtonAttachment bypassAttachment;
 
+   #if KRUSH_INSTRUMENTATION
+    juce::ToggleButton showPerformance;
+    PerformanceOverlay performanceOverlay{processorRef};
+   #endif
+
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioPluginAudioProcessorEditor)
 };
@@ -12,20 +12,38 @@ AudioPluginAudioProcessor::AudioPluginAudioProcessor()
                      #endif
                        )
 {
-    crush = dynamic_cast<juce::AudioParameterInt*>(apvts.getParameter("crush"));
     order = dynamic_cast<juce::AudioParameterInt*>(apvts.getParameter("order"));
+    size = dynamic_cast<juce::AudioParameterChoice*>(apvts.getParameter("size"));
     overlap = dynamic_cast<juce::AudioParameterInt*>(apvts.getParameter("overlap"));
+    stereo = dynamic_cast<juce::AudioParameterChoice*>(apvts.getParameter("stereo"));
+    resolution = dynamic_cast<juce::AudioParameterChoice*>(apvts.getParameter("resolution"));
+    sharedFFTs = dynamic_cast<juce::AudioParameterBool*>(apvts.getParameter("batch"));
     bypass = dynamic_cast<juce::AudioParameterBool*>(apvts.getParameter("bypass"));
     gain = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("gain"));
+    oversampling = dynamic_cast<juce::AudioParameterChoice*>(apvts.getParameter("oversampling"));
+    softClip = dynamic_cast<juce::AudioParameterBool*>(apvts.getParameter("clip"));
     mix = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("mix"));
 
+    for (const auto& [parameterID, chainParameter] : spectralParameters)
+        apvts.addParameterListener(parameterID, this);
+
     asyncUpdater.setCallback([this] { resetFFTs(); });
-    lastOrder = order->get();
-    lastHopSize = overlap->get();
+
+   #if KRUSH_INSTRUMENTATION
+    performance.setTraceRecorder(traceRecorder, instanceID);
+   #endif
+   #if KRUSH_SHARED_METRICS
+    metricsSegment = SharedMetricsSegment::create(instanceID);
+   #endif
+   #if KRUSH_SESSION_CAPTURE
+    sessionCapture = SessionCapture::create(instanceID, getParameters());
+   #endif
 }
 
 AudioPluginAudioProcessor::~AudioPluginAudioProcessor()
 {
+    for (const auto& [parameterID, chainParameter] : spectralParameters)
+        apvts.removeParameterListener(parameterID, this);
 }
 
 //==============================================================================
@@ -96,18 +114,39 @@ void AudioPluginAudioProcessor::changeProgramName (int index, const juce::String
 //==============================================================================
 void AudioPluginAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    for(auto& fft: fftMapLeft)
-    {
-        fft.second->reset();
-    }
-    for (auto &fft : fftMapRight)
-    {
-        fft.second->reset();
-    }
-
-    setLatencySamples(fftMapLeft.at(order->get())->getLatencyInSamples());
-
-    juce::ignoreUnused (sampleRate, samplesPerBlock);
+    const TraceRecorder::Scope trace(traceRecorder, "prepareToPlay", instanceID);
+    asyncUpdater.cancelPendingUpdate();
+
+    if (engine == nullptr || engine->getConfig() != getRequestedEngineConfig())
+        engine = makeEngine();
+
+    engine->setPerformanceCounters(performanceCounters);
+    engine->reset();
+    pendingEngine.reset();
+    pendingState = PendingState::idle;
+    rebuildRequested = false;
+    historyRequested = false;
+
+    spectralPath.prepare(juce::jmax(1, getTotalNumInputChannels()), samplesPerBlock);
+
+    parameterEvents.clear();
+    parameterEventsDropped = false;
+    samplePosition = 0;
+    syncChainParameters(engine->getChain());
+
+    osg.prepare(getTotalNumOutputChannels(), samplesPerBlock);
+    osg.setFactorIndex(oversampling->getIndex());
+    osg.reset();
+    gainBlockSize = samplesPerBlock;
+
+    activeLatency = getTotalLatency();
+    setLatencySamples(activeLatency);
+    publishMetricsConfig();
+
+   #if KRUSH_SESSION_CAPTURE
+    if (sessionCapture != nullptr)
+        sessionCapture->writePrepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
+   #endif
 }
 
 void AudioPluginAudioProcessor::releaseResources()
@@ -122,12 +161,9 @@ bool AudioPluginAudioProcessor::isBusesLayoutSupported (const BusesLayout& layou
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Anything from mono up to 7.1.4 runs through the one multichannel engine.
+    const auto numChannels = layouts.getMainOutputChannelSet().size();
+    if (numChannels == 0 || numChannels > juce::AudioChannelSet::create7point1point4().size())
         return false;
 
     // This checks if the input layout matches the output layout
@@ -142,18 +178,235 @@ bool AudioPluginAudioProcessor::isBusesLayoutSupported (const BusesLayout& layou
 
 void AudioPluginAudioProcessor::resetFFTs()
 {
-    for(auto& fft: fftMapLeft)
+    const TraceRecorder::Scope trace(traceRecorder, "resetFFTs", instanceID);
+
+    if (pendingState == PendingState::retired)
+    {
+        const TraceRecorder::Scope traceFree(traceRecorder, "Free engine", instanceID);
+        pendingEngine.reset();
+        pendingState = PendingState::idle;
+    }
+
+    setLatencySamples(activeLatency);
+
+    // The active engine only changes hands while an engine is pending, so while none is
+    // its smear history can be built here.
+    if (pendingState == PendingState::idle && historyRequested.exchange(false))
+    {
+        const TraceRecorder::Scope traceHistory(traceRecorder, "Allocate smear history", instanceID);
+        engine->getChain().getFreeze().allocateHistory();
+    }
+
+    if (pendingState == PendingState::idle && rebuildRequested.exchange(false))
     {
-        if(!fft.second->isFFTInUse())
-        fft.second->reset();
+        const TraceRecorder::Scope traceBuild(traceRecorder, "Build engine", instanceID);
+        pendingEngine = makeEngine();
+        pendingState.store(PendingState::ready, std::memory_order_release);
     }
-    for (auto &fft : fftMapRight)
+}
+
+void AudioPluginAudioProcessor::swapInPendingEngine()
+{
+    const TraceRecorder::Scope trace(traceRecorder, "Swap engine", instanceID);
+    std::swap(engine, pendingEngine);
+    engine->setPerformanceCounters(performanceCounters);
+    syncChainParameters(engine->getChain());
+
+    activeLatency = getTotalLatency();
+    publishMetricsConfig();
+    pendingState.store(PendingState::retired, std::memory_order_release);
+}
+
+std::unique_ptr<SpectralEngine> AudioPluginAudioProcessor::makeEngine() const
+{
+    auto newEngine = std::make_unique<SpectralEngine>(getRequestedEngineConfig());
+    if (apvts.getRawParameterValue("smear")->load() > 0.0f)
+        newEngine->getChain().getFreeze().allocateHistory();
+    newEngine->reset();
+    return newEngine;
+}
+
+SpectralEngineConfig AudioPluginAudioProcessor::getRequestedEngineConfig() const
+{
+    SpectralEngineConfig config;
+    config.fftSize = getRequestedFFTSize();
+    config.overlapOrder = overlap->get();
+    config.numChannels = juce::jmax(1, getTotalNumInputChannels());
+    config.numSpectralChannels = getRequestedSpectralChannels();
+    config.mode = static_cast<SpectralEngineConfig::Mode>(resolution->getIndex());
+    config.sampleRate = getSampleRate() > 0.0 ? getSampleRate() : 44100.0;
+    config.batched = sharedFFTs->get();
+    return config;
+}
+
+void AudioPluginAudioProcessor::parameterChanged(const juce::String& parameterID, float newValue)
+{
+    for (const auto& [id, chainParameter] : spectralParameters)
+        if (parameterID == id)
+            if (!parameterEvents.push({samplePosition.load(), static_cast<int>(chainParameter), toChainValue(chainParameter, newValue)}))
+                parameterEventsDropped.store(true, std::memory_order_release);
+}
+
+float AudioPluginAudioProcessor::toChainValue(SpectralChain::Parameter parameter, float value)
+{
+    // Smear is shown in ms but set in seconds.
+    return parameter == SpectralChain::Parameter::smear ? value * 0.001f : value;
+}
+
+void AudioPluginAudioProcessor::applyParameterEvents(SpectralChain& chain, juce::int64 position)
+{
+    parameterEvents.popUntil(position, [&chain](const ParameterEvent& event)
     {
-        if (!fft.second->isFFTInUse())
-            fft.second->reset();
+        chain.setParameter(static_cast<SpectralChain::Parameter>(event.parameter), event.value);
+    });
+
+    // The parameters themselves always hold the latest values, so they cover whatever
+    // didn't fit in the queue.
+    if (parameterEventsDropped.exchange(false, std::memory_order_acquire))
+        syncChainParameters(chain);
+}
+
+void AudioPluginAudioProcessor::syncChainParameters(SpectralChain& chain)
+{
+    for (const auto& [parameterID, chainParameter] : spectralParameters)
+    {
+        auto* parameter = dynamic_cast<juce::RangedAudioParameter*>(apvts.getParameter(parameterID));
+        chain.setParameter(chainParameter, toChainValue(chainParameter, parameter->convertFrom0to1(parameter->getValue())));
     }
+}
+
+bool AudioPluginAudioProcessor::isFrameLocal() const
+{
+    // The oversamplers round their latency up with a fractional delay, which is recursive.
+    return engine != nullptr && engine->isFrameLocal() && osg.getFactorIndex() == 0;
+}
+
+int AudioPluginAudioProcessor::getRenderAlignment() const
+{
+    return engine != nullptr ? engine->getHopAlignment() : 1;
+}
 
-    setLatencySamples(fftMapLeft.at(order->get())->getLatencyInSamples());
+void AudioPluginAudioProcessor::setAnalysisCache(SpectralAnalysisCache* cache)
+{
+    engine->setAnalysisCache(cache);
+}
+
+bool AudioPluginAudioProcessor::affectsAnalysis(const juce::String& parameterID)
+{
+    // The window, its overlap and resolution, what goes into the transforms, and the
+    // frequency limits, since a range with no bins in it skips the transforms altogether.
+    return juce::StringArray{"order", "size", "overlap", "stereo", "resolution", "batch", "low", "high"}.contains(parameterID);
+}
+
+void AudioPluginAudioProcessor::allocateSmearHistory()
+{
+    engine->getChain().getFreeze().allocateHistory();
+}
+
+bool AudioPluginAudioProcessor::isSpectralParameter(const juce::String& parameterID)
+{
+    for (const auto& [id, chainParameter] : spectralParameters)
+        if (parameterID == id)
+            return true;
+
+    return false;
+}
+
+juce::Result AudioPluginAudioProcessor::scheduleParameterChange(const juce::String& parameterID, float value, juce::int64 position)
+{
+    auto* parameter = dynamic_cast<juce::RangedAudioParameter*>(apvts.getParameter(parameterID));
+    if (parameter == nullptr || !isSpectralParameter(parameterID))
+        return juce::Result::fail("Not a spectral parameter: " + parameterID);
+
+    if (!std::isfinite(value))
+        return juce::Result::fail("Bad value for " + parameterID + ": " + juce::String(value));
+
+    value = parameter->convertFrom0to1(parameter->convertTo0to1(value));
+
+    // Built here rather than when the change comes due, so the ring is adopted on the
+    // same frame whatever the block size.
+    if (parameterID == "smear")
+        allocateSmearHistory();
+
+    for (const auto& [id, chainParameter] : spectralParameters)
+        if (parameterID == id)
+            if (!parameterEvents.push({position, static_cast<int>(chainParameter), toChainValue(chainParameter, value)}))
+                return juce::Result::fail("Too many parameter changes queued at once");
+
+    return juce::Result::ok();
+}
+
+juce::Result AudioPluginAudioProcessor::setParameterFromText(const juce::String& parameterID, const juce::String& text)
+{
+    auto* parameter = apvts.getParameter(parameterID);
+    if (parameter == nullptr)
+        return juce::Result::fail("Unknown parameter: " + parameterID);
+
+    auto value = parameter->getValueForText(text);
+
+    if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(parameter))
+    {
+        auto index = choice->choices.indexOf(text, true);
+        if (index < 0 && text.containsOnly("0123456789"))
+            index = text.getIntValue();
+
+        if (!juce::isPositiveAndBelow(index, choice->choices.size()))
+            return juce::Result::fail("Bad value for " + parameterID + ": " + text
+                                      + " (one of " + choice->choices.joinIntoString(", ") + ")");
+
+        value = choice->convertTo0to1((float) index);
+    }
+
+    parameter->setValueNotifyingHost(value);
+    return juce::Result::ok();
+}
+
+void AudioPluginAudioProcessor::publishMetricsConfig()
+{
+   #if KRUSH_SHARED_METRICS
+    if (metricsSegment == nullptr)
+        return;
+
+    auto& metrics = metricsSegment->getMetrics();
+    const auto& config = engine->getConfig();
+
+    metrics.sampleRate.store(getSampleRate(), std::memory_order_relaxed);
+    metrics.blockSize.store(getBlockSize(), std::memory_order_relaxed);
+    metrics.fftSize.store(config.fftSize, std::memory_order_relaxed);
+    metrics.overlapOrder.store(config.overlapOrder, std::memory_order_relaxed);
+    metrics.resolution.store((int) config.mode, std::memory_order_relaxed);
+    metrics.batched.store(config.batched ? 1 : 0, std::memory_order_relaxed);
+    metrics.oversampling.store(osg.getFactorIndex(), std::memory_order_relaxed);
+    metrics.memoryBytes.store(engine->getMemoryFootprint() + spectralPath.getMemoryFootprint(), std::memory_order_relaxed);
+   #endif
+}
+
+int AudioPluginAudioProcessor::getTotalLatency() const
+{
+    return engine->getLatencyInSamples() + osg.getLatencyInSamples();
+}
+
+int AudioPluginAudioProcessor::getRequestedFFTSize() const
+{
+    // "size" overrides the power of two order when it's set to anything but Off.
+    if (size->getIndex() > 0)
+        return WindowSizes::mixedRadix[(size_t) size->getIndex() - 1];
+
+    return 1 << order->get();
+}
+
+int AudioPluginAudioProcessor::getRequestedSpectralChannels() const
+{
+    // Mid Only transforms the mid channel and only delays the side.
+    if (isMidSide() && stereo->getIndex() == 2)
+        return 1;
+
+    return juce::jmax(1, getTotalNumInputChannels());
+}
+
+bool AudioPluginAudioProcessor::isMidSide() const
+{
+    return stereo->getIndex() > 0 && getTotalNumInputChannels() == 2;
 }
 
 void AudioPluginAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
@@ -162,96 +415,119 @@ void AudioPluginAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     juce::ignoreUnused (midiMessages);
 
     juce::ScopedNoDenormals noDenormals;
+    const TraceRecorder::Scope trace(traceRecorder, "processBlock", instanceID);
+   #if KRUSH_SESSION_CAPTURE
+    if (sessionCapture != nullptr)
+        sessionCapture->beginBlock(buffer, getTotalNumInputChannels());
+   #endif
+   #if KRUSH_INSTRUMENTATION
+    performance.beginBlock();
+   #endif
+   #if KRUSH_SHARED_METRICS
+    const auto metricsStart = juce::Time::getHighResolutionTicks();
+    const auto inputSilent = buffer.getMagnitude(0, buffer.getNumSamples()) == 0.0f;
+   #endif
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
-    juce::AudioBuffer<float> copyBuffer;
-    copyBuffer.makeCopyOf(buffer);
-
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
     
-    const auto& bitRateValue = crush->get();
-
-    if(lastOrder != order->get())
+    if(engine->getConfig() != getRequestedEngineConfig())
     {
-        const auto& newFFTLeft = fftMapLeft.at(order->get());
-        const auto& newFFTRight = fftMapRight.at(order->get());
-        if(newFFTLeft->isFFTReady() && newFFTRight->isFFTReady())
-        {   
-            newFFTLeft->setFFTInUse(true);
-            newFFTRight->setFFTInUse(true);
-            fftMapLeft.at(lastOrder)->prepFFTForReset();
-            fftMapRight.at(lastOrder)->prepFFTForReset();
-            newFFTLeft->handleHopSizeChange(overlap->get());
-            newFFTRight->handleHopSizeChange(overlap->get());
-            asyncUpdater.triggerAsyncUpdate();
-            lastOrder = order->get();
-        }
+        // Either swap in the engine the message thread built, or ask it to build one.
+        if (pendingState.load(std::memory_order_acquire) == PendingState::ready)
+            swapInPendingEngine();
+        else
+            rebuildRequested = true;
+
+        asyncUpdater.triggerAsyncUpdate();
+        if (traceRecorder != nullptr)
+            traceRecorder->record("Async update requested", TraceRecorder::Phase::instant, instanceID);
     }
 
-    if(lastHopSize != overlap->get()) //Needs to be checked when fft changes as well, fix in update
+    if (osg.getFactorIndex() != oversampling->getIndex())
     {
-        fftMapLeft.at(lastOrder)->handleHopSizeChange(overlap->get());
-        fftMapRight.at(lastOrder)->handleHopSizeChange(overlap->get());
-        lastHopSize = overlap->get();
+        const TraceRecorder::Scope traceOversampling(traceRecorder, "Oversampling change", instanceID);
+        osg.setFactorIndex(oversampling->getIndex());
+        activeLatency = getTotalLatency();
+        publishMetricsConfig();
+        asyncUpdater.triggerAsyncUpdate();
+        if (traceRecorder != nullptr)
+            traceRecorder->record("Async update requested", TraceRecorder::Phase::instant, instanceID);
     }
 
-    auto bitcrush = [this, bitRateValue](std::complex<float> *fft_data) 
+    // Spectral parameter changes come through the event queue, each stamped with the input
+    // sample it's due at: the block start for the host's, which JUCE gives no offset for,
+    // or the automation's own times for the offline tools'. The block is split at each one,
+    // so it reaches every band from the first frame that holds its sample, whatever the
+    // block size.
+    auto& chain = engine->getChain();
+    const auto blockStart = samplePosition.load();
+    auto spectralEffects = [&chain](SpectralFrame& frame) { chain.process(frame); };
+
+    const auto numSamples = buffer.getNumSamples();
+    jassert(engine->getNumChannels() <= buffer.getNumChannels());
+
+    SpectralPath::Settings settings;
+    settings.midSide = isMidSide();
+    settings.bypassed = bypass->get();
+    settings.wetGain = mix->get();
+
+    // Bypass still goes through the oversamplers at unity gain, so it keeps the reported
+    // latency. Host blocks longer than the prepared size go through in pieces.
+    const auto waitingForHistory = chain.getFreeze().needsHistory();
+    for (int start = 0; start < numSamples;)
     {
-        auto numBins = (1 << lastOrder) / 2 + 1;
-        for (int bin = 1; bin < numBins; bin++) 
-        {
-            float magnitude = std::abs(fft_data[bin]);
-            float phase = std::arg(fft_data[bin]);
-            auto crusher = pow(2, 16);
-            double crushedData = floor(crusher * magnitude) / crusher;
-
-            magnitude = static_cast<float>(crushedData);
-
-            if (bitRateValue > 1)
-            {
-                if (bin % bitRateValue != 0)
-                {
-                    auto redux = std::abs(fft_data[bin - bin % bitRateValue]);
-                    magnitude = redux;
-                }
-            }
-            fft_data[bin] = std::polar(magnitude, phase);
-        }
-    };
+        // One from the message thread can come in stamped behind the piece it lands in.
+        applyParameterEvents(chain, blockStart + start);
+        const auto nextEvent = parameterEvents.getNextPosition() - blockStart;
+        const auto end = (int) juce::jlimit((juce::int64) start + 1, (juce::int64) numSamples, nextEvent);
+
+        juce::AudioBuffer<float> piece(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), start, end - start);
+        settings.spectralBypassed = !chain.hasBinsInRange();
+        spectralPath.process(*engine, piece.getArrayOfWritePointers(), end - start, settings, spectralEffects, performanceCounters);
+        start = end;
+    }
 
-    float *dataLeft = buffer.getWritePointer(0);
-    float *dataRight = buffer.getWritePointer(1);
-    float *copyLeft = copyBuffer.getWritePointer(0);
-    float *copyRight = copyBuffer.getWritePointer(1);
+    samplePosition = blockStart + numSamples;
 
-    if(totalNumInputChannels == 1)
+    // Smear's history is only allocated once it's turned up, on the message thread.
+    if (chain.getFreeze().needsHistory())
     {
-        dataRight = buffer.getWritePointer(0);
-        copyRight = buffer.getWritePointer(0);
+        if (!historyRequested.exchange(true))
+            asyncUpdater.triggerAsyncUpdate();
     }
-
-    for (int i = 0; i < buffer.getNumSamples(); ++i)
+    else if (waitingForHistory)
     {
-        copyLeft[i] = fftMapLeft.at(lastOrder)->processSample(dataLeft[i], false, bitcrush); //I need this to be seperate ffts because I need different buffers
-        copyRight[i] = fftMapRight.at(lastOrder)->processSample(dataRight[i], false, bitcrush);
+        publishMetricsConfig();
     }
-    
-    if(!bypass->get())
+
+    // The oversamplers are sized for the prepared block, so longer host blocks go in pieces.
+    auto block = juce::dsp::AudioBlock<float>(buffer).getSubsetChannelBlock(0, (size_t) totalNumOutputChannels);
     {
-        for (int i = 0; i < buffer.getNumSamples(); ++i) //add mix
+        KRUSH_TIME_STAGE(performanceCounters, gain);
+        for (int start = 0; start < numSamples; start += gainBlockSize)
         {
-            dataLeft[i] = copyLeft[i] * mix->get() + dataLeft[i] * (1 - mix->get());
-            dataRight[i] = copyRight[i] * mix->get() + dataRight[i] * (1 - mix->get());
+            auto gainBlock = block.getSubBlock((size_t) start, (size_t) juce::jmin(gainBlockSize, numSamples - start));
+            osg.process(gainBlock, settings.bypassed ? 0.0f : gain->get(), !settings.bypassed && softClip->get());
         }
+    }
 
-        auto block = juce::dsp::AudioBlock<float>(buffer); //add gain
-        for(int channel = 0; channel < totalNumOutputChannels; ++channel)
-        {
-            osg.process(block, gain->get(), channel);
-        }
+   #if KRUSH_INSTRUMENTATION
+    performance.endBlock(numSamples, getSampleRate());
+   #endif
+   #if KRUSH_SHARED_METRICS
+    if (metricsSegment != nullptr)
+    {
+        const auto microseconds = 1.0e6 * juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - metricsStart);
+        metricsSegment->getMetrics().recordCallback(microseconds, numSamples, getSampleRate(), inputSilent, settings.bypassed);
     }
+   #endif
+   #if KRUSH_SESSION_CAPTURE
+    if (sessionCapture != nullptr)
+        sessionCapture->endBlock();
+   #endif
 }
 
 //==============================================================================
@@ -290,11 +566,36 @@ juce::AudioProcessorValueTreeState::ParameterLayout AudioPluginAudioProcessor::c
     auto orderAttributes = AudioParameterIntAttributes().withStringFromValueFunction([](int x, auto)
                                                                                            { return juce::String(1 << x); });
 
-    layout.add(std::make_unique<AudioParameterInt>(juce::ParameterID{"crush",1}, "Krush", 1, 25, 1));
-    layout.add(std::make_unique<AudioParameterInt>(juce::ParameterID{"order",1}, "Order", 8, 12, 10, orderAttributes));
-    layout.add(std::make_unique<AudioParameterInt>(juce::ParameterID{"overlap",1}, "Overlap", 2, 5, 2, orderAttributes));
+    layout.add(std::make_unique<AudioParameterInt>(juce::ParameterID{"crush",1}, "Krush", 1, SpectralCrush::maxCrush, 1));
+    layout.add(std::make_unique<AudioParameterChoice>(juce::ParameterID{"grouping",1}, "Grouping", StringArray{"Linear", "Log", "Bark"}, 0));
+    layout.add(std::make_unique<AudioParameterInt>(juce::ParameterID{"order",1}, "Order", WindowSizes::minOrder, WindowSizes::maxOrder, 10, orderAttributes));
+
+    StringArray sizeChoices{"Off"};
+    for (auto mixedSize : WindowSizes::mixedRadix)
+        sizeChoices.add(juce::String(mixedSize));
+    layout.add(std::make_unique<AudioParameterChoice>(juce::ParameterID{"size",1}, "Size", sizeChoices, 0));
+    layout.add(std::make_unique<AudioParameterInt>(juce::ParameterID{"overlap",1}, "Overlap", WindowSizes::minOverlapOrder, WindowSizes::maxOverlapOrder, 2, orderAttributes));
+    layout.add(std::make_unique<AudioParameterChoice>(juce::ParameterID{"stereo",1}, "Stereo", StringArray{"L/R", "M/S", "Mid Only"}, 0));
+    layout.add(std::make_unique<AudioParameterChoice>(juce::ParameterID{"resolution",1}, "Resolution", StringArray{"Single", "Multi", "Adaptive"}, 0));
+    layout.add(std::make_unique<AudioParameterBool>(juce::ParameterID{"batch",1}, "Shared FFTs", false));
+    layout.add(std::make_unique<AudioParameterBool>(juce::ParameterID{"freeze",1}, "Freeze", false));
+    auto smearRange = NormalisableRange<float>(0.f, (float) SpectralFreeze::maxSmearSeconds * 1000.f, 1.f, .5f);
+    auto smearAttributes = AudioParameterFloatAttributes().withStringFromValueFunction([](auto x, auto) { return juce::String(roundToInt(x)) + " ms"; });
+    layout.add(std::make_unique<AudioParameterFloat>(juce::ParameterID{"smear",1}, "Smear", smearRange, 0.f, smearAttributes));
+    layout.add(std::make_unique<AudioParameterFloat>(juce::ParameterID{"blur",1}, "Blur", mixRange, 0.f, mixAttributes));
+
+    auto gateAttributes = AudioParameterFloatAttributes().withStringFromValueFunction([](auto x, auto)
+                                                                                      { return x <= SpectralGate::offThreshold ? juce::String("Off") : juce::String(x, 1) + " dB"; });
+    layout.add(std::make_unique<AudioParameterFloat>(juce::ParameterID{"gate",1}, "Gate", NormalisableRange<float>(SpectralGate::offThreshold, 0.f, .1f), SpectralGate::offThreshold, gateAttributes));
+    layout.add(std::make_unique<AudioParameterFloat>(juce::ParameterID{"tilt",1}, "Tilt", NormalisableRange<float>(-6.f, 6.f, .1f), 0.f));
+
+    auto limitRange = NormalisableRange<float>(SpectralChain::minFrequency, SpectralChain::maxFrequency, 1.f, .25f);
+    layout.add(std::make_unique<AudioParameterFloat>(juce::ParameterID{"low",1}, "Low Limit", limitRange, SpectralChain::minFrequency));
+    layout.add(std::make_unique<AudioParameterFloat>(juce::ParameterID{"high",1}, "High Limit", limitRange, SpectralChain::maxFrequency));
     layout.add(std::make_unique<AudioParameterBool>(juce::ParameterID{"bypass",1}, "Bypass", false));
     layout.add(std::make_unique<AudioParameterFloat>(juce::ParameterID{"gain",1}, "Gain", -24.f, 24.f, 0.f));
+    layout.add(std::make_unique<AudioParameterChoice>(juce::ParameterID{"oversampling",1}, "Oversampling", StringArray{"Off", "2x", "4x", "8x"}, 0));
+    layout.add(std::make_unique<AudioParameterBool>(juce::ParameterID{"clip",1}, "Soft Clip", false));
     layout.add(std::make_unique<AudioParameterFloat>(juce::ParameterID{"mix",1}, "Mix", mixRange, 1.f, mixAttributes));
     
     return layout;
@@ -1,12 +1,20 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
-#include "DSP/FFTProcessor.h"
+#include "DSP/SpectralEngine.h"
+#include "DSP/SpectralPath.h"
+#include "DSP/WindowSizes.h"
 #include "Utility/overSampleGain.h"
 #include "Utility/KiTiKAsyncUpdater.h"
+#include "Utility/ParameterEventQueue.h"
+#include "Utility/PerformanceCounters.h"
+#include "Utility/SessionCapture.h"
+#include "Utility/SharedMetrics.h"
+#include "Utility/TraceRecorder.h"
 
 //==============================================================================
-class AudioPluginAudioProcessor final : public juce::AudioProcessor
+class AudioPluginAudioProcessor final : public juce::AudioProcessor,
+                                        private juce::AudioProcessorValueTreeState::Listener
 {
 public:
     //==============================================================================
@@ -49,35 +57,129 @@ public:
     juce::AudioProcessorValueTreeState apvts{*this, nullptr, "parameters", createParameterLayout()};
     void resetFFTs();
 
+    // For offline rendering, valid after prepareToPlay. With frame local settings, output
+    // sample n (once the latency is taken off) only depends on input from
+    // n - getLatencySamples() onwards, so a file can be rendered in pieces that each start
+    // that far early, on a multiple of getRenderAlignment() so every hop lines up.
+    bool isFrameLocal() const;
+    int getRenderAlignment() const;
+
+    // For offline rendering: attach after prepareToPlay to record the engine's forward
+    // transforms into the cache or replay them from it. Renders can share a cache as long
+    // as their input, block size and every parameter that affectsAnalysis() are the same.
+    void setAnalysisCache(SpectralAnalysisCache* cache);
+    static bool affectsAnalysis(const juce::String& parameterID);
+
+   #if KRUSH_INSTRUMENTATION
+    // Per-stage timing of the last block, for the editor's performance overlay.
+    const PerformanceCounters& getPerformanceCounters() const { return performance; }
+    void resetWorstCallback() { performance.resetWorst(); }
+   #endif
+
+    // For the command line tools: sets a parameter from its text, or a choice from its
+    // name or index, and fails on an unknown ID or choice.
+    juce::Result setParameterFromText(const juce::String& parameterID, const juce::String& text);
+
+    // For hosts without a message loop, like the offline tools: builds smear's history now,
+    // after prepareToPlay and between blocks, rather than on the message thread once smear
+    // is turned up.
+    void allocateSmearHistory();
+
+    // The parameters the spectral chain runs on, which can change at any sample.
+    static bool isSpectralParameter(const juce::String& parameterID);
+
+    // For the offline tools, after prepareToPlay and between blocks: queues a spectral
+    // parameter's value, in its own units, for the input sample at position (counted from
+    // prepareToPlay), so it lands in the same place whatever the block size. Only the chain
+    // sees it, not the parameter. Changes have to be queued in order of position; fails on
+    // any other parameter, a non-finite value or a full queue.
+    juce::Result scheduleParameterChange(const juce::String& parameterID, float value, juce::int64 position);
+
 private:
 
     overSampleGain osg;
-
-    FFTProcessor fft8Left{8, 2};
-    FFTProcessor fft9Left{9, 2};
-    FFTProcessor fft10Left{10, 2};
-    FFTProcessor fft11Left{11, 2};
-    FFTProcessor fft12Left{12, 2};
-
-    FFTProcessor fft8Right{8, 2};
-    FFTProcessor fft9Right{9, 2};
-    FFTProcessor fft10Right{10, 2};
-    FFTProcessor fft11Right{11, 2};
-    FFTProcessor fft12Right{12, 2};
-
-    std::map<int, FFTProcessor*> fftMapLeft{{8, &fft8Left}, {9, &fft9Left}, {10, &fft10Left}, {11, &fft11Left}, {12, &fft12Left}};
-    std::map<int, FFTProcessor *> fftMapRight{{8, &fft8Right}, {9, &fft9Right}, {10, &fft10Right}, {11, &fft11Right}, {12, &fft12Right}};
+    int gainBlockSize{0};
+    SpectralPath spectralPath;
+
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    static float toChainValue(SpectralChain::Parameter parameter, float value);
+    void applyParameterEvents(SpectralChain& chain, juce::int64 position);
+    void syncChainParameters(SpectralChain& chain);
+    int getTotalLatency() const;
+    int getRequestedFFTSize() const;
+    int getRequestedSpectralChannels() const;
+    SpectralEngineConfig getRequestedEngineConfig() const;
+    bool isMidSide() const;
+    void swapInPendingEngine();
+    // Tells krush-top what the engine is running now; a no-op without KRUSH_SHARED_METRICS.
+    void publishMetricsConfig();
+    std::unique_ptr<SpectralEngine> makeEngine() const;
+
+    // Only the active engine is allocated. A change of config builds the pending engine on
+    // the message thread; the audio thread swaps it in and hands the old one back to be freed.
+    enum class PendingState { idle, ready, retired };
+
+    std::unique_ptr<SpectralEngine> engine;
+    std::unique_ptr<SpectralEngine> pendingEngine;
+    std::atomic<PendingState> pendingState{PendingState::idle};
+    std::atomic<bool> rebuildRequested{false};
+    std::atomic<bool> historyRequested{false};
+    std::atomic<int> activeLatency{0};
 
     KiTiKAsyncUpdater asyncUpdater; 
 
-    int lastOrder{1};
-    int lastHopSize{1};
+    // Numbers the instances in a process, for the trace and the shared metrics.
+    static inline std::atomic<int> nextInstanceID{0};
+    const int instanceID = nextInstanceID++;
+
+   #if KRUSH_INSTRUMENTATION
+    PerformanceCounters performance;
+    PerformanceCounters* const performanceCounters = &performance;
+    // Shared by every instance in the process; null unless KRUSH_TRACE asks for a trace.
+    juce::SharedResourcePointer<TraceRecorder> sharedTraceRecorder;
+    TraceRecorder* const traceRecorder = sharedTraceRecorder->isRecording() ? static_cast<TraceRecorder*>(sharedTraceRecorder) : nullptr;
+   #else
+    PerformanceCounters* const performanceCounters = nullptr;
+    TraceRecorder* const traceRecorder = nullptr;
+   #endif
+
+   #if KRUSH_SHARED_METRICS
+    std::unique_ptr<SharedMetricsSegment> metricsSegment;
+   #endif
+
+   #if KRUSH_SESSION_CAPTURE
+    // Only while KRUSH_CAPTURE is set, see SessionCapture.
+    std::unique_ptr<SessionCapture> sessionCapture;
+   #endif
+
+    static constexpr std::array<std::pair<const char*, SpectralChain::Parameter>, 9> spectralParameters{{
+        {"crush", SpectralChain::Parameter::crush},
+        {"grouping", SpectralChain::Parameter::grouping},
+        {"freeze", SpectralChain::Parameter::freeze},
+        {"smear", SpectralChain::Parameter::smear},
+        {"blur", SpectralChain::Parameter::blur},
+        {"gate", SpectralChain::Parameter::gate},
+        {"tilt", SpectralChain::Parameter::tilt},
+        {"low", SpectralChain::Parameter::lowLimit},
+        {"high", SpectralChain::Parameter::highLimit}}};
+
+    // The host's changes are queued at the position the audio thread has reached, so they're
+    // due by the start of the next block; scheduled ones at their own. If the queue fills
+    // up with the host's, the chain is set from the parameters' latest values instead.
+    ParameterEventQueue parameterEvents{1024};
+    std::atomic<bool> parameterEventsDropped{false};
+    std::atomic<juce::int64> samplePosition{0};
 
-    juce::AudioParameterInt* crush{nullptr};
     juce::AudioParameterInt* order{nullptr};
+    juce::AudioParameterChoice* size{nullptr};
     juce::AudioParameterInt* overlap{nullptr};
+    juce::AudioParameterChoice* stereo{nullptr};
+    juce::AudioParameterChoice* resolution{nullptr};
+    juce::AudioParameterBool* sharedFFTs{nullptr};
     juce::AudioParameterBool* bypass{nullptr};
     juce::AudioParameterFloat* gain{nullptr};
+    juce::AudioParameterChoice* oversampling{nullptr};
+    juce::AudioParameterBool* softClip{nullptr};
     juce::AudioParameterFloat* mix{nullptr};
 
     //==============================================================================
@@ -0,0 +1,58 @@
+#include "ChunkedRenderer.h"
+
+ChunkedRenderer::ChunkedRenderer(std::vector<std::unique_ptr<FileRenderer>>& workerRenderers)
+    : renderers(workerRenderers), pool((int) workerRenderers.size()),
+      chunks(workerRenderers.size() * chunksPerWorker)
+{
+}
+
+juce::Result ChunkedRenderer::render(const juce::File& input, const juce::File& output)
+{
+    auto& first = *renderers.front();
+    if (renderers.size() == 1 || !first.canRenderInChunks(input))
+        return first.render(input, output);
+
+    auto reader = first.createReader(input);
+    if (reader == nullptr)
+        return juce::Result::fail("Can't read " + input.getFullPathName());
+
+    // Every chunk pays for a latency's worth of pre-roll, so keep them well above that.
+    const auto length = reader->lengthInSamples;
+    const auto chunkSize = (juce::int64) juce::jmax(minChunkSize, 8 * first.getProcessor().getLatencySamples());
+    const auto numChunks = (int) ((length + chunkSize - 1) / chunkSize);
+
+    juce::TemporaryFile temporary(output);
+    auto writer = first.createWriter(temporary.getFile(), *reader, length);
+    if (writer == nullptr)
+        return juce::Result::fail("Can't write " + output.getFullPathName());
+
+    for (int wave = 0; wave < numChunks; wave += (int) chunks.size())
+    {
+        const auto waveSize = juce::jmin((int) chunks.size(), numChunks - wave);
+        std::vector<juce::Result> results((size_t) waveSize, juce::Result::ok());
+
+        pool.run(waveSize, [&](int job, int worker)
+        {
+            const auto start = (wave + job) * chunkSize;
+            const auto numSamples = (int) juce::jmin(chunkSize, length - start);
+            results[(size_t) job] = renderers[(size_t) worker]->renderChunk(input, start, numSamples, chunks[(size_t) job]);
+        });
+
+        for (int job = 0; job < waveSize; ++job)
+        {
+            if (results[(size_t) job].failed())
+                return results[(size_t) job];
+
+            const auto& chunk = chunks[(size_t) job];
+            if (!writer->writeFromAudioSampleBuffer(chunk, 0, chunk.getNumSamples()))
+                return juce::Result::fail("Write failed: " + output.getFullPathName());
+        }
+    }
+
+    writer.reset();
+
+    if (!temporary.overwriteTargetFileWithTemporary())
+        return juce::Result::fail("Can't replace " + output.getFullPathName());
+
+    return juce::Result::ok();
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "FileRenderer.h"
+#include "../Utility/WorkStealingPool.h"
+
+/*
+  Renders one file on every worker at once. STFT frames only meet at the overlap-add, so
+  the file is cut into chunks and each worker renders a chunk on its own processor,
+  started a latency's worth of input early and on a hop and block boundary. Every frame
+  that reaches a chunk has then seen exactly the input, hop alignment and block sequence
+  it would have in a straight render, so the output is bit-identical to
+  FileRenderer::render().
+
+  That only holds for frame local settings (no freeze, smear, transient adaptive mode or
+  oversampling). Anything else falls back to a straight render on the first worker.
+
+  Chunks go out in waves of a few per worker and are written in order after each wave,
+  so memory stays bounded however long the file is.
+ */
+class ChunkedRenderer
+{
+public:
+    static constexpr int minChunkSize = 1 << 17;
+    static constexpr int chunksPerWorker = 2;
+
+    // One renderer per worker, all with the same settings applied.
+    explicit ChunkedRenderer(std::vector<std::unique_ptr<FileRenderer>>& workerRenderers);
+
+    juce::Result render(const juce::File& input, const juce::File& output);
+
+private:
+    std::vector<std::unique_ptr<FileRenderer>>& renderers;
+    WorkStealingPool pool;
+    std::vector<juce::AudioBuffer<float>> chunks;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChunkedRenderer)
+};
@@ -0,0 +1,282 @@
+#include "FileRenderer.h"
+#include "PreallocatedFileOutputStream.h"
+
+FileRenderer::FileRenderer(const Settings& newSettings)
+    : settings(newSettings)
+{
+    formatManager.registerBasicFormats();
+    processor.setNonRealtime(true);
+}
+
+// Runs input positions [from, to) through the prepared processor in blocks, with silence
+// past the end of the file, and hands each processed block in `buffer` to useBlock.
+template <typename UseBlock>
+juce::Result FileRenderer::processRange(juce::AudioFormatReader& reader, juce::int64 from, juce::int64 to, UseBlock&& useBlock)
+{
+    const auto numChannels = (int) reader.numChannels;
+    const auto started = settings.automation.start(processor, reader.sampleRate, from);
+    if (started.failed())
+        return started;
+
+    for (auto position = from; position < to; position += settings.blockSize)
+    {
+        const auto numSamples = (int) juce::jmin((juce::int64) settings.blockSize, to - position);
+        buffer.setSize(numChannels, numSamples, false, false, true);
+
+        if (!readBlock(reader, position, buffer))
+            return juce::Result::fail("Read failed");
+
+        const auto scheduled = settings.automation.schedule(processor, reader.sampleRate, from, position, position + numSamples);
+        if (scheduled.failed())
+            return scheduled;
+
+        processor.processBlock(buffer, midi);
+
+        if (!useBlock(position, numSamples))
+            return juce::Result::fail("Write failed");
+    }
+
+    return juce::Result::ok();
+}
+
+juce::Result FileRenderer::applySettings()
+{
+    if (settings.preset != juce::File())
+    {
+        if (!settings.preset.existsAsFile())
+            return juce::Result::fail("Preset not found: " + settings.preset.getFullPathName());
+
+        juce::ValueTree state;
+        if (auto xml = juce::XmlDocument::parse(settings.preset))
+        {
+            state = juce::ValueTree::fromXml(*xml);
+        }
+        else
+        {
+            juce::MemoryBlock data;
+            settings.preset.loadFileAsData(data);
+            state = juce::ValueTree::readFromData(data.getData(), data.getSize());
+        }
+
+        if (!state.isValid() || !state.hasType(processor.apvts.state.getType()))
+            return juce::Result::fail("Not a Krush preset: " + settings.preset.getFullPathName());
+
+        processor.apvts.replaceState(state);
+    }
+
+    return applyParameters(settings.parameters);
+}
+
+juce::Result FileRenderer::applyParameters(const juce::StringPairArray& parameters)
+{
+    for (const auto& parameterID : parameters.getAllKeys())
+    {
+        const auto result = processor.setParameterFromText(parameterID, parameters[parameterID]);
+        if (result.failed())
+            return result;
+    }
+
+    return juce::Result::ok();
+}
+
+juce::Result FileRenderer::render(const juce::File& input, const juce::File& output)
+{
+    auto reader = createReader(input);
+    if (reader == nullptr)
+        return juce::Result::fail("Can't read " + input.getFullPathName());
+
+    const auto numChannels = (int) reader->numChannels;
+    const auto prepared = prepare(numChannels, reader->sampleRate);
+    if (prepared.failed())
+        return prepared;
+
+    // Written next to the target and moved over it at the end, so a failed render never
+    // leaves half a file behind.
+    juce::TemporaryFile temporary(output);
+    auto writer = createWriter(temporary.getFile(), *reader, reader->lengthInSamples);
+    if (writer == nullptr)
+        return juce::Result::fail("Can't write " + output.getFullPathName());
+
+    const auto latency = (juce::int64) processor.getLatencySamples();
+    RenderPipeline pipeline(numChannels, settings.blockSize);
+    processor.setAnalysisCache(analysisCache);
+
+    // Blocks reach the processor in order, so it can keep its own count of where it is.
+    auto automated = settings.automation.start(processor, reader->sampleRate, 0);
+    juce::int64 processPosition = 0;
+
+    const auto processed = pipeline.run(reader->lengthInSamples + latency,
+        [&](juce::int64 position, juce::AudioBuffer<float>& block)
+        {
+            return readBlock(*reader, position, block);
+        },
+        [&](juce::AudioBuffer<float>& block)
+        {
+            const auto numSamples = block.getNumSamples();
+            if (automated.wasOk())
+                automated = settings.automation.schedule(processor, reader->sampleRate, 0, processPosition, processPosition + numSamples);
+
+            processor.processBlock(block, midi);
+            processPosition += numSamples;
+        },
+        [&](juce::int64 position, const juce::AudioBuffer<float>& block)
+        {
+            const auto numSamples = block.getNumSamples();
+            const auto skip = (int) juce::jlimit((juce::int64) 0, (juce::int64) numSamples, latency - position);
+            return writer->writeFromAudioSampleBuffer(block, skip, numSamples - skip);
+        });
+
+    processor.setAnalysisCache(nullptr);
+    processor.releaseResources();
+    writer.reset();
+
+    if (processed.failed())
+        return juce::Result::fail(processed.getErrorMessage() + ": " + input.getFullPathName());
+
+    if (automated.failed())
+        return juce::Result::fail(automated.getErrorMessage() + ": " + input.getFullPathName());
+
+    if (!temporary.overwriteTargetFileWithTemporary())
+        return juce::Result::fail("Can't replace " + output.getFullPathName());
+
+    return juce::Result::ok();
+}
+
+juce::Result FileRenderer::renderChunk(const juce::File& input, juce::int64 start, int numSamples, juce::AudioBuffer<float>& destination)
+{
+    const auto opened = openChunkInput(input);
+    if (opened.failed())
+        return opened;
+
+    jassert(processor.isFrameLocal());
+
+    // Start early enough that every frame reaching the chunk saw only real input, on a
+    // boundary where the hops and the blocks fall exactly where they do in render().
+    const auto latency = (juce::int64) processor.getLatencySamples();
+    const auto alignment = (juce::int64) std::lcm(processor.getRenderAlignment(), settings.blockSize);
+    const auto preRoll = juce::jmax((juce::int64) 0, start - latency);
+    const auto from = preRoll / alignment * alignment;
+    const auto end = start + numSamples;
+
+    destination.setSize((int) chunkReader->numChannels, numSamples, false, false, true);
+
+    const auto processed = processRange(*chunkReader, from, end + latency, [&](juce::int64 position, int blockSize)
+    {
+        // Output sample n comes out of the processor at input position n + latency.
+        const auto first = juce::jmax(position, start + latency);
+        const auto last = juce::jmin(position + blockSize, end + latency);
+
+        for (int c = 0; c < destination.getNumChannels() && first < last; ++c)
+            destination.copyFrom(c, (int) (first - latency - start), buffer, c, (int) (first - position), (int) (last - first));
+
+        return true;
+    });
+
+    if (processed.failed())
+        return juce::Result::fail(processed.getErrorMessage() + ": " + input.getFullPathName());
+
+    return juce::Result::ok();
+}
+
+bool FileRenderer::canRenderInChunks(const juce::File& input)
+{
+    return openChunkInput(input).wasOk() && processor.isFrameLocal() && settings.automation.isFrameLocal();
+}
+
+std::unique_ptr<juce::AudioFormatReader> FileRenderer::createReader(const juce::File& input)
+{
+    for (auto* format : formatManager)
+    {
+        if (!format->canHandleFile(input))
+            continue;
+
+        if (std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped{format->createMemoryMappedReader(input)})
+            return mapped;
+    }
+
+    return std::unique_ptr<juce::AudioFormatReader>(formatManager.createReaderFor(input));
+}
+
+// Fills the block from position on, with silence past the end of the file. Memory mapped
+// readers only map the window being read, so the mapping stays small for any length.
+bool FileRenderer::readBlock(juce::AudioFormatReader& reader, juce::int64 position, juce::AudioBuffer<float>& block)
+{
+    block.clear();
+
+    const auto numToRead = (int) juce::jlimit((juce::int64) 0, (juce::int64) block.getNumSamples(), reader.lengthInSamples - position);
+    if (numToRead == 0)
+        return true;
+
+    if (auto* mapped = dynamic_cast<juce::MemoryMappedAudioFormatReader*>(&reader))
+    {
+        const juce::Range<juce::int64> needed(position, position + numToRead);
+        if (!mapped->getMappedSection().contains(needed)
+            && !mapped->mapSectionOfFile({position, juce::jmin(reader.lengthInSamples, position + juce::jmax(mapWindowSize, (juce::int64) numToRead))}))
+            return false;
+    }
+
+    return reader.read(&block, 0, numToRead, position, true, true);
+}
+
+juce::File FileRenderer::getOutputFile(const juce::File& input, const juce::File& outputDirectory) const
+{
+    const auto extension = settings.format.isEmpty() ? input.getFileExtension() : "." + settings.format;
+    return outputDirectory.getChildFile(input.getFileNameWithoutExtension() + extension);
+}
+
+juce::Result FileRenderer::openChunkInput(const juce::File& input)
+{
+    if (chunkReader == nullptr || chunkInput != input)
+    {
+        chunkReader = createReader(input);
+        chunkInput = input;
+        if (chunkReader == nullptr)
+            return juce::Result::fail("Can't read " + input.getFullPathName());
+    }
+
+    return prepare((int) chunkReader->numChannels, chunkReader->sampleRate);
+}
+
+juce::Result FileRenderer::prepare(int numChannels, double sampleRate)
+{
+    const auto channelSet = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(channelSet);
+    layout.outputBuses.add(channelSet);
+
+    if (!processor.setBusesLayout(layout))
+        return juce::Result::fail("Unsupported channel count: " + juce::String(numChannels));
+
+    processor.setRateAndBufferSizeDetails(sampleRate, settings.blockSize);
+    processor.prepareToPlay(sampleRate, settings.blockSize);
+    buffer.setSize(numChannels, settings.blockSize);
+    return juce::Result::ok();
+}
+
+std::unique_ptr<juce::AudioFormatWriter> FileRenderer::createWriter(const juce::File& output, const juce::AudioFormatReader& reader,
+                                                                   juce::int64 expectedLength)
+{
+    auto* format = formatManager.findFormatForFileExtension(output.getFileExtension());
+    if (format == nullptr)
+        return nullptr;
+
+    // Keep the requested depth where the format has it, otherwise the deepest it has under it.
+    const auto requestedBits = settings.bitsPerSample > 0 ? settings.bitsPerSample : (int) reader.bitsPerSample;
+    const auto possibleBits = format->getPossibleBitDepths();
+    auto bits = possibleBits.getFirst();
+    for (auto possible : possibleBits)
+        if (possible <= requestedBits)
+            bits = juce::jmax(bits, possible);
+
+    // Room for the samples uncompressed plus headers; the stream trims what isn't used.
+    const auto expectedBytes = expectedLength * reader.numChannels * (bits / 8) + 65536;
+    std::unique_ptr<juce::OutputStream> stream = std::make_unique<PreallocatedFileOutputStream>(output, expectedBytes);
+    if (!static_cast<PreallocatedFileOutputStream&>(*stream).openedOk())
+        return nullptr;
+
+    return format->createWriterFor(stream, juce::AudioFormatWriterOptions{}
+                                               .withSampleRate(reader.sampleRate)
+                                               .withNumChannels((int) reader.numChannels)
+                                               .withBitsPerSample(bits));
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "../PluginProcessor.h"
+#include "ParameterAutomation.h"
+#include "RenderPipeline.h"
+
+/*
+  Renders audio files offline through the plugin's own AudioPluginAudioProcessor, driven
+  the way a host drives it: set the parameters, prepare for the file's rate and channel
+  count, then call processBlock in blocks. The processor's latency is taken off the
+  front, and a latency's worth of silence is run through at the end, so the output lines
+  up with the input and has the same length.
+
+  render() streams: WAV and AIFF inputs are memory mapped a window at a time, and reading,
+  processing and encoding overlap on three threads through a RenderPipeline. The output
+  is written into a file preallocated to its expected size. Memory use doesn't depend on
+  the length of the file.
+
+  One renderer owns one processor and is meant to be used by one thread at a time.
+  krush-render keeps one per worker.
+ */
+class FileRenderer
+{
+public:
+    struct Settings
+    {
+        // A preset written by the plugin, either as XML or as its binary state.
+        juce::File preset;
+        // Parameter ID to value text, applied after the preset. Choices take the choice
+        // name or its index, everything else the value as the plugin displays it.
+        juce::StringPairArray parameters;
+        // Curves for the spectral parameters, run on top of the values above.
+        ParameterAutomation automation;
+        int blockSize = 512;
+        // "wav", "aiff" or "flac"; empty writes the input's format.
+        juce::String format;
+        // 0 keeps the input's bit depth.
+        int bitsPerSample = 0;
+    };
+
+    explicit FileRenderer(const Settings& newSettings);
+
+    // Loads the preset and parameters into the processor. Call once before rendering.
+    juce::Result applySettings();
+
+    // Sets more parameters on top of the settings, in the same format.
+    juce::Result applyParameters(const juce::StringPairArray& parameters);
+
+    // render() records into or replays from the cache while it's set (see
+    // SpectralAnalysisCache). The cache has to outlive its use here.
+    void setAnalysisCache(SpectralAnalysisCache* cache) { analysisCache = cache; }
+
+    juce::Result render(const juce::File& input, const juce::File& output);
+
+    /*
+      Renders output samples [start, start + numSamples) of a file into destination, the
+      same as render() would have written them, by starting the processor some way before
+      start. Only valid when the settings are frame local (see canRenderInChunks), which
+      is what lets ChunkedRenderer split one file across threads.
+     */
+    juce::Result renderChunk(const juce::File& input, juce::int64 start, int numSamples, juce::AudioBuffer<float>& destination);
+
+    // Opens the file and prepares the processor for it, then reports whether renderChunk()
+    // can be used with the current settings.
+    bool canRenderInChunks(const juce::File& input);
+
+    // Memory mapped where the format supports it.
+    std::unique_ptr<juce::AudioFormatReader> createReader(const juce::File& input);
+
+    // The file is preallocated for expectedLength samples at the writer's bit depth.
+    std::unique_ptr<juce::AudioFormatWriter> createWriter(const juce::File& output, const juce::AudioFormatReader& reader,
+                                                          juce::int64 expectedLength);
+
+    // Where render() should write a given input inside outputDirectory.
+    juce::File getOutputFile(const juce::File& input, const juce::File& outputDirectory) const;
+
+    AudioPluginAudioProcessor& getProcessor() { return processor; }
+
+private:
+    juce::Result prepare(int numChannels, double sampleRate);
+    juce::Result openChunkInput(const juce::File& input);
+    static bool readBlock(juce::AudioFormatReader& reader, juce::int64 position, juce::AudioBuffer<float>& block);
+
+    template <typename UseBlock>
+    juce::Result processRange(juce::AudioFormatReader& reader, juce::int64 from, juce::int64 to, UseBlock&& useBlock);
+
+    static constexpr juce::int64 mapWindowSize = 1 << 20;
+
+    Settings settings;
+    juce::AudioFormatManager formatManager;
+    AudioPluginAudioProcessor processor;
+    std::unique_ptr<juce::AudioFormatReader> chunkReader;
+    juce::File chunkInput;
+    juce::AudioBuffer<float> buffer;
+    juce::MidiBuffer midi;
+    SpectralAnalysisCache* analysisCache = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FileRenderer)
+};
@@ -0,0 +1,91 @@
+#include "ParameterAutomation.h"
+
+juce::Result ParameterAutomation::add(const juce::String& assignment)
+{
+    Curve curve;
+    curve.parameterID = assignment.upToFirstOccurrenceOf("=", false, false).trim();
+    if (!AudioPluginAudioProcessor::isSpectralParameter(curve.parameterID))
+        return juce::Result::fail("Only the spectral parameters can be automated: " + curve.parameterID);
+
+    juce::StringArray points;
+    points.addTokens(assignment.fromFirstOccurrenceOf("=", false, false), ",", "");
+    points.trim();
+    points.removeEmptyStrings();
+
+    for (const auto& point : points)
+    {
+        const auto seconds = point.upToFirstOccurrenceOf(":", false, false).trim();
+        const auto value = point.fromFirstOccurrenceOf(":", false, false).trim();
+        if (!point.contains(":") || !seconds.containsOnly("0123456789.") || !value.containsOnly("-0123456789.e"))
+            return juce::Result::fail("Bad automation point for " + curve.parameterID + ": " + point);
+
+        curve.points.emplace_back(seconds.getDoubleValue(), value.getFloatValue());
+    }
+
+    if (curve.points.empty())
+        return juce::Result::fail("No automation points for " + curve.parameterID);
+
+    std::stable_sort(curve.points.begin(), curve.points.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    curves.push_back(std::move(curve));
+    return juce::Result::ok();
+}
+
+bool ParameterAutomation::isFrameLocal() const
+{
+    return std::none_of(curves.begin(), curves.end(), [](const Curve& curve)
+    {
+        return curve.parameterID == "freeze" || curve.parameterID == "smear";
+    });
+}
+
+juce::Result ParameterAutomation::start(AudioPluginAudioProcessor& processor, double sampleRate, juce::int64 origin) const
+{
+    // The value of the step origin falls in, which is the one in force there.
+    const auto seconds = (double) (origin / stepSize * stepSize) / sampleRate;
+
+    for (const auto& curve : curves)
+    {
+        const auto scheduled = processor.scheduleParameterChange(curve.parameterID, curve.getValue(seconds), 0);
+        if (scheduled.failed())
+            return scheduled;
+    }
+
+    return juce::Result::ok();
+}
+
+juce::Result ParameterAutomation::schedule(AudioPluginAudioProcessor& processor, double sampleRate, juce::int64 origin,
+                                           juce::int64 from, juce::int64 to) const
+{
+    // Steps go out in order of position, every curve's at each, as the queue needs them.
+    const auto firstStep = juce::jmax(from, origin + 1) + stepSize - 1;
+    for (auto step = firstStep / stepSize * stepSize; step < to; step += stepSize)
+    {
+        for (const auto& curve : curves)
+        {
+            const auto value = curve.getValue((double) step / sampleRate);
+            if (value == curve.getValue((double) (step - stepSize) / sampleRate))
+                continue;
+
+            const auto scheduled = processor.scheduleParameterChange(curve.parameterID, value, step - origin);
+            if (scheduled.failed())
+                return scheduled;
+        }
+    }
+
+    return juce::Result::ok();
+}
+
+float ParameterAutomation::Curve::getValue(double seconds) const
+{
+    auto next = std::find_if(points.begin(), points.end(), [seconds](const auto& point) { return point.first > seconds; });
+    if (next == points.begin())
+        return next->second;
+    if (next == points.end())
+        return points.back().second;
+
+    const auto& [startSeconds, startValue] = *(next - 1);
+    const auto& [endSeconds, endValue] = *next;
+    const auto position = (seconds - startSeconds) / (endSeconds - startSeconds);
+    return startValue + (float) position * (endValue - startValue);
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "../PluginProcessor.h"
+
+/*
+  Automation curves for krush-render. Each curve moves one of the spectral parameters
+  along straight lines between (seconds, value) points, holding the first value before
+  them and the last after. A curve is stepped every stepSize input samples, and each step
+  that changes its value is queued on the processor at that sample (see
+  AudioPluginAudioProcessor::scheduleParameterChange), so the output doesn't depend on
+  the block size. A step is about 5 ms at 48 kHz, and a block can hold as many as the
+  processor's event queue has room for.
+ */
+class ParameterAutomation
+{
+public:
+    static constexpr int stepSize = 256;
+
+    // Adds a curve from "<id>=<seconds>:<value>,<seconds>:<value>,...", with the values in
+    // the parameter's own units.
+    juce::Result add(const juce::String& assignment);
+
+    // False if a curve moves freeze or smear, which carry state from one frame to the next.
+    bool isFrameLocal() const;
+
+    // Queues every curve's value at input sample origin for the processor's first sample.
+    // Call after prepareToPlay, with origin where the processor starts in the input.
+    juce::Result start(AudioPluginAudioProcessor& processor, double sampleRate, juce::int64 origin) const;
+
+    // Queues the steps in input samples [from, to), before the block that covers them.
+    juce::Result schedule(AudioPluginAudioProcessor& processor, double sampleRate, juce::int64 origin,
+                          juce::int64 from, juce::int64 to) const;
+
+private:
+    struct Curve
+    {
+        juce::String parameterID;
+        std::vector<std::pair<double, float>> points;
+
+        float getValue(double seconds) const;
+    };
+
+    std::vector<Curve> curves;
+};
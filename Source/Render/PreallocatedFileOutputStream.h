@@ -0,0 +1,75 @@
+#pragma once
+#include <juce_core/juce_core.h>
+
+#if JUCE_LINUX || JUCE_BSD
+ #include <fcntl.h>
+ #include <unistd.h>
+#endif
+
+/*
+  Writes a file that was given its expected size up front, so the filesystem can lay the
+  whole output out in one go instead of extending it a block at a time while the encoder
+  runs. On Linux the space is reserved with posix_fallocate; elsewhere the file is just
+  extended to that length. Whatever the writer didn't use is cut off when the stream is
+  deleted, so an estimate on the high side is fine.
+ */
+class PreallocatedFileOutputStream : public juce::OutputStream
+{
+public:
+    PreallocatedFileOutputStream(const juce::File& file, juce::int64 expectedSize)
+        : stream(preallocate(file, expectedSize))
+    {
+        // FileOutputStream opens existing files at the end.
+        stream.setPosition(0);
+    }
+
+    ~PreallocatedFileOutputStream() override
+    {
+        if (!stream.openedOk())
+            return;
+
+        stream.flush();
+        stream.setPosition(end);
+        stream.truncate();
+    }
+
+    bool openedOk() const { return stream.openedOk(); }
+
+    void flush() override { stream.flush(); }
+    bool setPosition(juce::int64 newPosition) override { return stream.setPosition(newPosition); }
+    juce::int64 getPosition() override { return stream.getPosition(); }
+
+    bool write(const void* data, size_t numBytes) override
+    {
+        const auto written = stream.write(data, numBytes);
+        end = juce::jmax(end, stream.getPosition());
+        return written;
+    }
+
+private:
+    static const juce::File& preallocate(const juce::File& file, juce::int64 size)
+    {
+       #if JUCE_LINUX || JUCE_BSD
+        const auto fd = ::open(file.getFullPathName().toRawUTF8(), O_WRONLY | O_CREAT, 0644);
+        if (fd >= 0)
+        {
+            ::posix_fallocate(fd, 0, (off_t) size);
+            ::close(fd);
+        }
+       #else
+        juce::FileOutputStream extend(file);
+        if (extend.openedOk() && size > 0)
+        {
+            extend.setPosition(size - 1);
+            extend.writeByte(0);
+        }
+       #endif
+
+        return file;
+    }
+
+    juce::FileOutputStream stream;
+    juce::int64 end = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PreallocatedFileOutputStream)
+};
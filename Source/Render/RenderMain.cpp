@@ -0,0 +1,341 @@
+#include "ChunkedRenderer.h"
+#include "SweepRenderer.h"
+#include <iostream>
+
+/*
+  krush-render: runs audio files through Krush without a host.
+
+    krush-render -o <dir> [options] <files or directories...>
+
+  Directories are searched recursively for anything the readers understand, and their
+  layout is kept under the output directory. With at least as many files as workers the
+  files are spread over the workers; with fewer, they go one at a time, each split across
+  every worker by ChunkedRenderer.
+
+  With --sweep the files go one at a time through SweepRenderer, which writes every
+  combination of the swept values and shares the analysis between them where it can.
+
+  With --check-blocks nothing is written: each file is rendered at block sizes 32 and 4096
+  with the same settings and automation, and fails if the two come out different.
+ */
+
+namespace
+{
+    struct Job
+    {
+        juce::File input, output;
+    };
+
+    void printUsage()
+    {
+        std::cout << "Usage: krush-render -o <dir> [options] <files or directories...>\n"
+                     "  -o, --output <dir>       where the rendered files go\n"
+                     "  -p, --preset <file>      preset to load before the --set values\n"
+                     "  -s, --set <id>=<value>   set a parameter, can be repeated\n"
+                     "      --sweep <id>=<list>  render every value, as a,b,c or first..last;\n"
+                     "                           repeat for a grid of all the combinations\n"
+                     "      --automate <id>=<s>:<value>,...\n"
+                     "                           move a spectral parameter along straight lines\n"
+                     "                           between the points, at times in seconds\n"
+                     "  -f, --format <fmt>       wav, aiff or flac (default: the input's)\n"
+                     "  -b, --bits <n>           bit depth (default: the input's)\n"
+                     "  -j, --threads <n>        worker threads (default: one per core)\n"
+                     "      --block <n>          host block size (default: 512)\n"
+                     "      --check-blocks       check each file renders the same at block\n"
+                     "                           sizes 32 and 4096 instead of writing it\n"
+                     "      --list-parameters    print the parameter IDs and exit\n";
+    }
+
+    void listParameters()
+    {
+        AudioPluginAudioProcessor processor;
+        for (auto* parameter : processor.getParameters())
+        {
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            {
+                std::cout << ranged->getParameterID() << "  " << ranged->getName(64) << "  default "
+                          << ranged->getText(ranged->getDefaultValue(), 64) << "\n";
+            }
+        }
+    }
+
+    SweepRenderer::Dimension parseSweep(const juce::String& assignment)
+    {
+        SweepRenderer::Dimension dimension;
+        dimension.parameterID = assignment.upToFirstOccurrenceOf("=", false, false).trim();
+        const auto values = assignment.fromFirstOccurrenceOf("=", false, false).trim();
+
+        if (values.contains(".."))
+        {
+            const auto first = values.upToFirstOccurrenceOf("..", false, false).getIntValue();
+            const auto last = values.fromFirstOccurrenceOf("..", false, false).getIntValue();
+            for (auto value = first; value <= last; ++value)
+                dimension.values.add(juce::String(value));
+        }
+        else
+        {
+            dimension.values.addTokens(values, ",", "");
+            dimension.values.trim();
+            dimension.values.removeEmptyStrings();
+        }
+
+        return dimension;
+    }
+
+    // Renders the file at both block sizes into temporary files and compares them sample
+    // for sample. Fails if they differ anywhere by more than blockCheckTolerance.
+    constexpr std::array<int, 2> checkedBlockSizes{32, 4096};
+    constexpr float blockCheckTolerance = 1.0e-6f;
+
+    juce::Result checkBlockSizes(FileRenderer::Settings settings, const juce::File& input, float& maxDifference)
+    {
+        settings.format = "wav";
+        settings.bitsPerSample = 32;
+
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        std::vector<std::unique_ptr<juce::TemporaryFile>> outputs;
+        std::vector<std::unique_ptr<juce::AudioFormatReader>> readers;
+        for (auto blockSize : checkedBlockSizes)
+        {
+            settings.blockSize = blockSize;
+            FileRenderer renderer(settings);
+            outputs.push_back(std::make_unique<juce::TemporaryFile>(".wav"));
+
+            auto result = renderer.applySettings();
+            if (result.wasOk())
+                result = renderer.render(input, outputs.back()->getFile());
+            if (result.failed())
+                return result;
+
+            readers.emplace_back(formats.createReaderFor(outputs.back()->getFile()));
+            if (readers.back() == nullptr)
+                return juce::Result::fail("Can't read back the render at block " + juce::String(blockSize));
+        }
+
+        const auto numChannels = (int) readers[0]->numChannels;
+        const auto length = readers[0]->lengthInSamples;
+        if (readers[1]->numChannels != readers[0]->numChannels || readers[1]->lengthInSamples != length)
+            return juce::Result::fail("The renders at different block sizes have different shapes");
+
+        juce::AudioBuffer<float> first(numChannels, 65536), second(numChannels, 65536);
+        maxDifference = 0.0f;
+        for (juce::int64 position = 0; position < length; position += first.getNumSamples())
+        {
+            const auto numSamples = (int) juce::jmin((juce::int64) first.getNumSamples(), length - position);
+            if (!readers[0]->read(&first, 0, numSamples, position, true, true)
+                || !readers[1]->read(&second, 0, numSamples, position, true, true))
+                return juce::Result::fail("Can't read back the renders");
+
+            for (int c = 0; c < numChannels; ++c)
+                for (int i = 0; i < numSamples; ++i)
+                    maxDifference = juce::jmax(maxDifference, std::abs(first.getSample(c, i) - second.getSample(c, i)));
+        }
+
+        if (maxDifference > blockCheckTolerance)
+            return juce::Result::fail("Blocks of " + juce::String(checkedBlockSizes[0]) + " and " + juce::String(checkedBlockSizes[1])
+                                      + " differ by up to " + juce::String(juce::Decibels::gainToDecibels(maxDifference), 1) + " dB");
+
+        return juce::Result::ok();
+    }
+
+    juce::Array<Job> findJobs(const juce::StringArray& inputs, const juce::File& outputDirectory,
+                              const FileRenderer& renderer, const juce::String& wildcard)
+    {
+        juce::Array<Job> jobs;
+        for (const auto& path : inputs)
+        {
+            const auto input = juce::File::getCurrentWorkingDirectory().getChildFile(path);
+            if (input.isDirectory())
+            {
+                for (const auto& file : input.findChildFiles(juce::File::findFiles, true, wildcard))
+                {
+                    const auto directory = outputDirectory.getChildFile(file.getParentDirectory().getRelativePathFrom(input));
+                    jobs.add({file, renderer.getOutputFile(file, directory)});
+                }
+            }
+            else
+            {
+                jobs.add({input, renderer.getOutputFile(input, outputDirectory)});
+            }
+        }
+        return jobs;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    FileRenderer::Settings settings;
+    juce::File outputDirectory;
+    juce::StringArray inputs;
+    std::vector<SweepRenderer::Dimension> sweeps;
+    auto numThreads = juce::SystemStats::getNumCpus();
+    auto checkingBlocks = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        const auto hasValue = i + 1 < argc;
+        auto value = [&] { return juce::String(argv[++i]); };
+
+        if ((arg == "-o" || arg == "--output") && hasValue)
+            outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(value());
+        else if ((arg == "-p" || arg == "--preset") && hasValue)
+            settings.preset = juce::File::getCurrentWorkingDirectory().getChildFile(value());
+        else if ((arg == "-s" || arg == "--set") && hasValue)
+        {
+            const auto assignment = value();
+            settings.parameters.set(assignment.upToFirstOccurrenceOf("=", false, false).trim(),
+                                    assignment.fromFirstOccurrenceOf("=", false, false).trim());
+        }
+        else if (arg == "--sweep" && hasValue)
+            sweeps.push_back(parseSweep(value()));
+        else if (arg == "--automate" && hasValue)
+        {
+            const auto added = settings.automation.add(value());
+            if (added.failed())
+            {
+                std::cerr << added.getErrorMessage() << "\n";
+                return 2;
+            }
+        }
+        else if (arg == "--check-blocks")
+            checkingBlocks = true;
+        else if ((arg == "-f" || arg == "--format") && hasValue)
+            settings.format = value().toLowerCase().trimCharactersAtStart(".");
+        else if ((arg == "-b" || arg == "--bits") && hasValue)
+            settings.bitsPerSample = value().getIntValue();
+        else if ((arg == "-j" || arg == "--threads") && hasValue)
+            numThreads = juce::jmax(1, value().getIntValue());
+        else if (arg == "--block" && hasValue)
+            settings.blockSize = juce::jlimit(16, 1 << 16, value().getIntValue());
+        else if (arg == "--list-parameters")
+        {
+            listParameters();
+            return 0;
+        }
+        else if (arg == "-h" || arg == "--help")
+        {
+            printUsage();
+            return 0;
+        }
+        else if (arg.startsWith("-"))
+        {
+            std::cerr << "Unknown option " << arg << "\n";
+            printUsage();
+            return 2;
+        }
+        else
+            inputs.add(arg);
+    }
+
+    if ((outputDirectory == juce::File() && !checkingBlocks) || inputs.isEmpty())
+    {
+        printUsage();
+        return 2;
+    }
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    if (checkingBlocks)
+    {
+        FileRenderer renderer(settings);
+        const auto applied = renderer.applySettings();
+        if (applied.failed())
+        {
+            std::cerr << applied.getErrorMessage() << "\n";
+            return 2;
+        }
+
+        const auto jobs = findJobs(inputs, juce::File::getSpecialLocation(juce::File::tempDirectory), renderer,
+                                   formats.getWildcardForAllFormats());
+        std::mutex printLock;
+        std::atomic<int> numFailed{0};
+
+        WorkStealingPool pool(numThreads);
+        pool.run(jobs.size(), [&](int index, int)
+        {
+            const auto& input = jobs.getReference(index).input;
+            auto maxDifference = 0.0f;
+            const auto checked = checkBlockSizes(settings, input, maxDifference);
+
+            const std::lock_guard<std::mutex> lock(printLock);
+            if (checked.wasOk())
+            {
+                std::cout << input.getFullPathName() << ": same at blocks of " << checkedBlockSizes[0] << " and "
+                          << checkedBlockSizes[1] << " (largest difference " << maxDifference << ")\n";
+            }
+            else
+            {
+                ++numFailed;
+                std::cerr << input.getFullPathName() << ": " << checked.getErrorMessage() << "\n";
+            }
+        });
+
+        std::cout << jobs.size() - numFailed << " of " << jobs.size() << " files render the same at both block sizes\n";
+        return numFailed == 0 ? 0 : 1;
+    }
+
+    // Every worker gets its own processor, all set up the same way before any of them start.
+    std::vector<std::unique_ptr<FileRenderer>> renderers;
+    for (int w = 0; w < numThreads; ++w)
+    {
+        renderers.push_back(std::make_unique<FileRenderer>(settings));
+        const auto applied = renderers.back()->applySettings();
+        if (applied.failed())
+        {
+            std::cerr << applied.getErrorMessage() << "\n";
+            return 2;
+        }
+    }
+
+    const auto jobs = findJobs(inputs, outputDirectory, *renderers.front(), formats.getWildcardForAllFormats());
+
+    std::mutex printLock;
+    std::atomic<int> numFailed{0};
+
+    const auto sweeping = !sweeps.empty();
+    const auto splitFiles = jobs.size() < numThreads;
+    ChunkedRenderer chunkedRenderer(renderers);
+    SweepRenderer sweepRenderer(renderers, sweeps);
+
+    WorkStealingPool pool(sweeping || splitFiles ? 1 : numThreads);
+    pool.run(jobs.size(), [&](int index, int worker)
+    {
+        const auto& job = jobs.getReference(index);
+        auto result = job.input == job.output ? juce::Result::fail("Output would overwrite the input")
+                                              : job.output.getParentDirectory().createDirectory();
+        if (result.wasOk())
+        {
+            if (sweeping)
+                result = sweepRenderer.render(job.input, job.output);
+            else if (splitFiles)
+                result = chunkedRenderer.render(job.input, job.output);
+            else
+                result = renderers[(size_t) worker]->render(job.input, job.output);
+        }
+
+        const std::lock_guard<std::mutex> lock(printLock);
+        if (result.wasOk() && sweeping)
+        {
+            std::cout << job.input.getFullPathName() << " -> " << sweepRenderer.getNumVariations() << " variations in "
+                      << job.output.getParentDirectory().getFullPathName() << "\n";
+        }
+        else if (result.wasOk())
+        {
+            std::cout << job.input.getFullPathName() << " -> " << job.output.getFullPathName() << "\n";
+        }
+        else
+        {
+            ++numFailed;
+            std::cerr << job.input.getFullPathName() << ": " << result.getErrorMessage() << "\n";
+        }
+    });
+
+    std::cout << jobs.size() - numFailed << " of " << jobs.size() << " files rendered\n";
+    return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/*
+  Runs a render as three overlapped stages: reading and decoding on one thread, the
+  processor on the calling thread, encoding and writing on a third. Blocks are handed
+  along through a fixed set of numSlots buffers, so a slow disk or encoder only stalls
+  the stages once every slot is queued behind it, and memory is the same for a one
+  second file as for a ten hour one.
+
+  Blocks go through every stage in order. After a read or write fails, the remaining
+  blocks still pass through (so no stage waits forever) but nothing more is done to them.
+ */
+class RenderPipeline
+{
+public:
+    static constexpr int numSlots = 8;
+
+    using Read = std::function<bool(juce::int64 position, juce::AudioBuffer<float>& block)>;
+    using Process = std::function<void(juce::AudioBuffer<float>& block)>;
+    using Write = std::function<bool(juce::int64 position, const juce::AudioBuffer<float>& block)>;
+
+    RenderPipeline(int numChannels, int maxBlockSize)
+        : blockSize(maxBlockSize)
+    {
+        for (int i = 0; i < numSlots; ++i)
+        {
+            slots[(size_t) i].index = i;
+            slots[(size_t) i].buffer.setSize(numChannels, blockSize);
+        }
+    }
+
+    // Runs [0, length) through the stages in blocks of up to maxBlockSize samples.
+    juce::Result run(juce::int64 length, const Read& read, const Process& process, const Write& write)
+    {
+        SlotQueue free, decoded, processed;
+        for (int i = 0; i < numSlots; ++i)
+            free.push(i);
+
+        const auto numBlocks = (length + blockSize - 1) / blockSize;
+        std::atomic<bool> readFailed{false}, writeFailed{false};
+
+        std::thread reader([&]
+        {
+            for (juce::int64 b = 0; b < numBlocks; ++b)
+            {
+                auto& slot = slots[(size_t) free.pop()];
+                slot.position = b * blockSize;
+                slot.buffer.setSize(slot.buffer.getNumChannels(), (int) juce::jmin((juce::int64) blockSize, length - slot.position),
+                                    false, false, true);
+
+                if (!readFailed && !writeFailed && !read(slot.position, slot.buffer))
+                    readFailed = true;
+
+                decoded.push(slot.index);
+            }
+        });
+
+        std::thread writer([&]
+        {
+            for (juce::int64 b = 0; b < numBlocks; ++b)
+            {
+                auto& slot = slots[(size_t) processed.pop()];
+                if (!readFailed && !writeFailed && !write(slot.position, slot.buffer))
+                    writeFailed = true;
+
+                free.push(slot.index);
+            }
+        });
+
+        for (juce::int64 b = 0; b < numBlocks; ++b)
+        {
+            auto& slot = slots[(size_t) decoded.pop()];
+            if (!readFailed && !writeFailed)
+                process(slot.buffer);
+
+            processed.push(slot.index);
+        }
+
+        reader.join();
+        writer.join();
+
+        if (readFailed)
+            return juce::Result::fail("Read failed");
+
+        if (writeFailed)
+            return juce::Result::fail("Write failed");
+
+        return juce::Result::ok();
+    }
+
+private:
+    struct Slot
+    {
+        int index = 0;
+        juce::int64 position = 0;
+        juce::AudioBuffer<float> buffer;
+    };
+
+    // Only numSlots indices ever exist, so the queues never grow past that.
+    class SlotQueue
+    {
+    public:
+        void push(int slot)
+        {
+            {
+                const std::lock_guard<std::mutex> lock(mutex);
+                slots.push_back(slot);
+            }
+            ready.notify_one();
+        }
+
+        int pop()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [this] { return !slots.empty(); });
+            const auto slot = slots.front();
+            slots.pop_front();
+            return slot;
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::deque<int> slots;
+    };
+
+    int blockSize;
+    std::array<Slot, numSlots> slots;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RenderPipeline)
+};
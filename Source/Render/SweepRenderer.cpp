@@ -0,0 +1,99 @@
+#include "SweepRenderer.h"
+#include <map>
+
+SweepRenderer::SweepRenderer(std::vector<std::unique_ptr<FileRenderer>>& workerRenderers, const std::vector<Dimension>& dimensions)
+    : renderers(workerRenderers), pool((int) workerRenderers.size())
+{
+    variations.emplace_back();
+    for (const auto& dimension : dimensions)
+    {
+        std::vector<Variation> expanded;
+        for (const auto& variation : variations)
+        {
+            for (const auto& value : dimension.values)
+            {
+                auto next = variation;
+                next.parameters.set(dimension.parameterID, value);
+                next.suffix << "_" << dimension.parameterID << "-"
+                            << juce::File::createLegalFileName(value).replaceCharacter(' ', '-');
+                expanded.push_back(next);
+            }
+        }
+        variations = std::move(expanded);
+    }
+
+    // Variations that agree on every value the analysis depends on land in the same group.
+    std::map<juce::String, int> groups;
+    for (size_t v = 0; v < variations.size(); ++v)
+    {
+        auto& variation = variations[v];
+        juce::String key;
+        for (const auto& parameterID : variation.parameters.getAllKeys())
+            if (AudioPluginAudioProcessor::affectsAnalysis(parameterID))
+                key << parameterID << "=" << variation.parameters[parameterID] << ";";
+
+        const auto found = groups.find(key);
+        if (found == groups.end())
+        {
+            variation.group = groups[key] = numGroups++;
+            recordings.push_back((int) v);
+        }
+        else
+        {
+            variation.group = found->second;
+            replays.push_back((int) v);
+        }
+    }
+}
+
+juce::Result SweepRenderer::render(const juce::File& input, const juce::File& output)
+{
+    std::vector<std::unique_ptr<SpectralAnalysisCache>> caches;
+    for (int g = 0; g < numGroups; ++g)
+        caches.push_back(std::make_unique<SpectralAnalysisCache>(memoryBudget / (size_t) numGroups));
+
+    std::vector<juce::Result> results(variations.size(), juce::Result::ok());
+
+    pool.run((int) recordings.size(), [&](int job, int worker)
+    {
+        const auto& variation = variations[(size_t) recordings[(size_t) job]];
+        auto& cache = *caches[(size_t) variation.group];
+
+        auto result = renderVariation(*renderers[(size_t) worker], variation, cache, input, output);
+        const auto finished = cache.finishRecording();
+        results[(size_t) recordings[(size_t) job]] = result.failed() ? result : finished;
+    });
+
+    pool.run((int) replays.size(), [&](int job, int worker)
+    {
+        const auto& variation = variations[(size_t) replays[(size_t) job]];
+        auto& result = results[(size_t) replays[(size_t) job]];
+
+        // A failed recording leaves nothing to replay.
+        result = results[(size_t) recordings[(size_t) variation.group]];
+        if (result.wasOk())
+            result = renderVariation(*renderers[(size_t) worker], variation, *caches[(size_t) variation.group], input, output);
+    });
+
+    for (const auto& result : results)
+        if (result.failed())
+            return result;
+
+    return juce::Result::ok();
+}
+
+juce::Result SweepRenderer::renderVariation(FileRenderer& renderer, const Variation& variation, SpectralAnalysisCache& cache,
+                                            const juce::File& input, const juce::File& output)
+{
+    const auto applied = renderer.applyParameters(variation.parameters);
+    if (applied.failed())
+        return applied;
+
+    const auto variationOutput = output.getSiblingFile(output.getFileNameWithoutExtension() + variation.suffix
+                                                       + output.getFileExtension());
+
+    renderer.setAnalysisCache(&cache);
+    const auto result = renderer.render(input, variationOutput);
+    renderer.setAnalysisCache(nullptr);
+    return result;
+}
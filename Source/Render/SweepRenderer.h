@@ -0,0 +1,55 @@
+#pragma once
+#include "FileRenderer.h"
+#include "../Utility/WorkStealingPool.h"
+
+/*
+  Renders one file once for every combination of the swept parameter values, each into
+  its own file with the values added to its name.
+
+  Variations that only differ in parameters the analysis doesn't depend on (crush,
+  grouping, the other effects, gain, mix...) share a SpectralAnalysisCache. The first
+  variation of each group renders normally and records its forward transforms, and the
+  rest replay them, so they only pay for their own spectral kernels, inverse transforms
+  and what comes after. The recordings run across the workers first, then the replays.
+
+  The caches of one file split memoryBudget between them and spill to temporary files
+  past it.
+ */
+class SweepRenderer
+{
+public:
+    struct Dimension
+    {
+        juce::String parameterID;
+        juce::StringArray values;
+    };
+
+    static constexpr size_t memoryBudget = (size_t) 1 << 31;
+
+    // One renderer per worker, all with the same settings applied.
+    SweepRenderer(std::vector<std::unique_ptr<FileRenderer>>& workerRenderers, const std::vector<Dimension>& dimensions);
+
+    int getNumVariations() const { return (int) variations.size(); }
+
+    // output is where render() would have written the file; the variations go next to it.
+    juce::Result render(const juce::File& input, const juce::File& output);
+
+private:
+    struct Variation
+    {
+        juce::StringPairArray parameters;
+        juce::String suffix;
+        int group = 0;
+    };
+
+    juce::Result renderVariation(FileRenderer& renderer, const Variation& variation, SpectralAnalysisCache& cache,
+                                 const juce::File& input, const juce::File& output);
+
+    std::vector<std::unique_ptr<FileRenderer>>& renderers;
+    WorkStealingPool pool;
+    std::vector<Variation> variations;
+    std::vector<int> recordings, replays;
+    int numGroups = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SweepRenderer)
+};
@@ -0,0 +1,131 @@
+#include "SessionReplay.h"
+#include <iostream>
+
+/*
+  krush-replay: runs a session captured from a host through Krush again, with the same
+  callbacks, inputs and automation, and compares the callback times with the live ones.
+
+    krush-replay [options] <capture.kcap>
+
+  Capture a session by setting KRUSH_CAPTURE to a directory before starting the host.
+  The replay runs on its own thread while this one delivers the processor's messages,
+  as a host's message thread would.
+ */
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage: krush-replay [options] <capture.kcap>\n"
+                     "  -n, --repeat <n>         replay the session n times (default: 1)\n"
+                     "      --paced              start each callback when it started live instead of\n"
+                     "                           running them back to back\n"
+                     "  -w, --worst <n>          list the n slowest replayed callbacks (default: 5)\n";
+    }
+
+    juce::String formatStatistics(const juce::String& label, const SessionReplay::Statistics& statistics)
+    {
+        auto column = [](double value) { return juce::String(value, 1).paddedLeft(' ', 10); };
+        return label.paddedRight(' ', 8) + column(statistics.p50) + column(statistics.p99) + column(statistics.p999)
+               + column(statistics.max) + juce::String(statistics.numMisses).paddedLeft(' ', 9);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    SessionReplay::Settings settings;
+    auto numWorst = 5;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        const auto hasValue = i + 1 < argc;
+        auto value = [&] { return juce::String(argv[++i]); };
+
+        if ((arg == "-n" || arg == "--repeat") && hasValue)
+            settings.repeats = juce::jmax(1, value().getIntValue());
+        else if (arg == "--paced")
+            settings.paced = true;
+        else if ((arg == "-w" || arg == "--worst") && hasValue)
+            numWorst = juce::jmax(0, value().getIntValue());
+        else if (arg == "-h" || arg == "--help")
+        {
+            printUsage();
+            return 0;
+        }
+        else if (!arg.startsWith("-") && settings.file == juce::File())
+            settings.file = juce::File::getCurrentWorkingDirectory().getChildFile(arg);
+        else
+        {
+            std::cerr << "Unknown option " << arg << "\n";
+            printUsage();
+            return 2;
+        }
+    }
+
+    if (settings.file == juce::File())
+    {
+        printUsage();
+        return 2;
+    }
+
+    SessionReplay replay(settings);
+    SessionReplay::Report report;
+    auto result = juce::Result::ok();
+
+    juce::Thread::launch([&]
+    {
+        result = replay.run(report);
+        juce::MessageManager::getInstance()->stopDispatchLoop();
+    });
+    juce::MessageManager::getInstance()->runDispatchLoop();
+
+    if (result.failed())
+    {
+        std::cerr << result.getErrorMessage() << "\n";
+        return 1;
+    }
+
+    for (const auto& parameterID : report.unknownParameters)
+        std::cerr << "Warning: this build has no parameter " << parameterID << ", its changes were skipped\n";
+
+    std::cout << settings.file.getFileName() << ": " << report.callbacks.size() << " callbacks, "
+              << report.numPrepares << " prepares, " << report.numDropped << " dropped while capturing";
+    if (report.sizeLimited)
+        std::cout << ", stopped at the size limit";
+    if (report.truncated)
+        std::cout << ", cut off";
+    std::cout << "\n\n";
+
+    std::cout << "            p50 us    p99 us  p99.9 us    max us   missed\n"
+              << formatStatistics("live", report.getStatistics(&SessionReplay::Callback::liveMicroseconds)) << "\n"
+              << formatStatistics("replay", report.getStatistics(&SessionReplay::Callback::replayMicroseconds)) << "\n";
+
+    auto worst = report.callbacks;
+    numWorst = juce::jmin(numWorst, (int) worst.size());
+    std::partial_sort(worst.begin(), worst.begin() + numWorst, worst.end(), [](const auto& a, const auto& b)
+    {
+        return a.replayMicroseconds > b.replayMicroseconds;
+    });
+
+    if (numWorst > 0)
+        std::cout << "\nSlowest replayed callbacks:\n";
+
+    for (int i = 0; i < numWorst; ++i)
+    {
+        const auto& callback = worst[(size_t) i];
+        std::cout << "  #" << juce::String(callback.index).paddedRight(' ', 9)
+                  << "at " << juce::String(callback.startSeconds, 3).paddedLeft(' ', 9) << " s  "
+                  << juce::String(callback.numSamples).paddedLeft(' ', 5) << " samples  live "
+                  << juce::String(callback.liveMicroseconds, 1).paddedLeft(' ', 8) << " us  replay "
+                  << juce::String(callback.replayMicroseconds, 1).paddedLeft(' ', 8) << " us  budget "
+                  << juce::String(callback.budgetMicroseconds, 1).paddedLeft(' ', 8) << " us";
+        if (callback.changes.isNotEmpty())
+            std::cout << "  changed " << callback.changes;
+        std::cout << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include "SessionReader.h"
+
+SessionReader::SessionReader(const juce::File& fileToRead)
+    : file(fileToRead)
+{
+}
+
+juce::Result SessionReader::open()
+{
+    auto fileStream = std::make_unique<juce::FileInputStream>(file);
+    if (fileStream->failedToOpen())
+        return juce::Result::fail("Can't open " + file.getFullPathName());
+
+    stream = std::make_unique<juce::BufferedInputStream>(fileStream.release(), 1 << 16, true);
+
+    if ((juce::uint32) stream->readInt() != SessionCapture::magicNumber)
+        return juce::Result::fail(file.getFileName() + " isn't a Krush session capture");
+
+    if (const auto version = (juce::uint32) stream->readInt(); version != SessionCapture::formatVersion)
+        return juce::Result::fail(file.getFileName() + " is capture format " + juce::String(version)
+                                  + ", this build reads " + juce::String(SessionCapture::formatVersion));
+
+    const auto numParameters = stream->readInt();
+    for (int i = 0; i < numParameters && !stream->isExhausted(); ++i)
+    {
+        const auto length = (size_t) (juce::uint16) stream->readShort();
+        juce::HeapBlock<char> utf8(length + 1, true);
+        if (!read(utf8.get(), length))
+            return juce::Result::fail(file.getFileName() + " is cut off in its header");
+
+        parameterIDs.add(juce::String::fromUTF8(utf8.get(), (int) length));
+    }
+
+    if (parameterIDs.size() != numParameters)
+        return juce::Result::fail(file.getFileName() + " is cut off in its header");
+
+    return juce::Result::ok();
+}
+
+bool SessionReader::readNext(Record& record)
+{
+    if (ended || stream == nullptr)
+        return false;
+
+    juce::uint8 type = 0;
+    if (!read(&type, sizeof(type)))
+    {
+        truncated = true;
+        return false;
+    }
+
+    record.type = static_cast<SessionCapture::RecordType>(type);
+    auto complete = true;
+
+    switch (record.type)
+    {
+        case SessionCapture::RecordType::prepare:
+        {
+            juce::int32 blockSize = 0, numChannels = 0;
+            record.values.resize((size_t) parameterIDs.size());
+            complete = read(&record.sampleRate, sizeof(double)) && read(&blockSize, sizeof(blockSize))
+                       && read(&numChannels, sizeof(numChannels))
+                       && read(record.values.data(), record.values.size() * sizeof(float));
+            record.blockSize = blockSize;
+            record.numChannels = numChannels;
+            break;
+        }
+
+        case SessionCapture::RecordType::block:
+        {
+            juce::int32 numSamples = 0;
+            juce::uint16 numChannels = 0, numChanges = 0;
+            complete = read(&record.startMicroseconds, sizeof(double)) && read(&record.liveMicroseconds, sizeof(float))
+                       && read(&numSamples, sizeof(numSamples)) && read(&numChannels, sizeof(numChannels))
+                       && read(&numChanges, sizeof(numChanges));
+
+            record.changes.clear();
+            for (int i = 0; complete && i < numChanges; ++i)
+            {
+                juce::uint16 index = 0;
+                auto value = 0.0f;
+                complete = read(&index, sizeof(index)) && read(&value, sizeof(value));
+                record.changes.emplace_back((int) index, value);
+            }
+
+            record.numChannels = numChannels;
+            record.input.setSize(numChannels, numSamples, false, false, true);
+            for (int c = 0; complete && c < numChannels; ++c)
+                complete = read(record.input.getWritePointer(c), (size_t) numSamples * sizeof(float));
+            break;
+        }
+
+        case SessionCapture::RecordType::gap:
+            complete = read(&record.numDropped, sizeof(record.numDropped));
+            break;
+
+        case SessionCapture::RecordType::end:
+        {
+            juce::uint8 reason = 0;
+            complete = read(&reason, sizeof(reason));
+            record.endReason = static_cast<SessionCapture::EndReason>(reason);
+            ended = true;
+            break;
+        }
+
+        default:
+            complete = false;
+            break;
+    }
+
+    if (!complete)
+    {
+        truncated = true;
+        ended = true;
+        return false;
+    }
+
+    return true;
+}
+
+bool SessionReader::read(void* destination, size_t numBytes)
+{
+    return numBytes == 0 || stream->read(destination, numBytes) == (int) numBytes;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "../Utility/SessionCapture.h"
+
+/*
+  Reads back a file SessionCapture wrote, one record at a time, so a long session never
+  has to fit in memory. A file that stops without its end record, because the process
+  died or the capture was cut short, reads up to the last whole record and then reports
+  itself truncated.
+ */
+class SessionReader
+{
+public:
+    struct Record
+    {
+        SessionCapture::RecordType type = SessionCapture::RecordType::end;
+
+        // Prepare: the parameter values are normalised, in the order of getParameterIDs().
+        double sampleRate = 0.0;
+        int blockSize = 0;
+        int numChannels = 0;
+        std::vector<float> values;
+
+        // Block: the input holds numChannels channels of the block's samples.
+        double startMicroseconds = 0.0;
+        float liveMicroseconds = 0.0f;
+        std::vector<std::pair<int, float>> changes;
+        juce::AudioBuffer<float> input;
+
+        // Gap and end.
+        juce::uint32 numDropped = 0;
+        SessionCapture::EndReason endReason = SessionCapture::EndReason::closed;
+    };
+
+    explicit SessionReader(const juce::File& fileToRead);
+
+    juce::Result open();
+    const juce::StringArray& getParameterIDs() const { return parameterIDs; }
+
+    // False once there are no more whole records.
+    bool readNext(Record& record);
+    bool isTruncated() const { return truncated; }
+
+private:
+    bool read(void* destination, size_t numBytes);
+
+    juce::File file;
+    std::unique_ptr<juce::InputStream> stream;
+    juce::StringArray parameterIDs;
+    bool ended = false;
+    bool truncated = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SessionReader)
+};
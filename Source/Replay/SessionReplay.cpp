@@ -0,0 +1,162 @@
+#include "SessionReplay.h"
+#include <thread>
+
+SessionReplay::SessionReplay(const Settings& newSettings)
+    : settings(newSettings)
+{
+}
+
+juce::Result SessionReplay::run(Report& report)
+{
+    for (int repeat = 0; repeat < settings.repeats; ++repeat)
+    {
+        const auto replayed = replayOnce(report);
+        if (replayed.failed())
+            return replayed;
+    }
+
+    return juce::Result::ok();
+}
+
+juce::Result SessionReplay::replayOnce(Report& report)
+{
+    SessionReader reader(settings.file);
+    const auto opened = reader.open();
+    if (opened.failed())
+        return opened;
+
+    parameterIDs = reader.getParameterIDs();
+    parameters.clear();
+    for (const auto& parameterID : parameterIDs)
+    {
+        auto* parameter = processor.apvts.getParameter(parameterID);
+        if (parameter == nullptr)
+            report.unknownParameters.addIfNotAlreadyThere(parameterID);
+        parameters.push_back(parameter);
+    }
+
+    SessionReader::Record record;
+    juce::int64 originTicks = 0;
+    auto firstBlock = true;
+
+    while (reader.readNext(record))
+    {
+        switch (record.type)
+        {
+            case SessionCapture::RecordType::prepare:
+                prepare(record);
+                ++report.numPrepares;
+                break;
+
+            case SessionCapture::RecordType::block:
+            {
+                if (sampleRate <= 0.0)
+                    return juce::Result::fail(settings.file.getFileName() + " has a block before any prepare");
+
+                Callback callback;
+                callback.index = (juce::int64) report.callbacks.size();
+                callback.startSeconds = record.startMicroseconds * 1.0e-6;
+                callback.numSamples = record.input.getNumSamples();
+                callback.budgetMicroseconds = 1.0e6 * callback.numSamples / sampleRate;
+                callback.liveMicroseconds = record.liveMicroseconds;
+
+                juce::StringArray changed;
+                for (const auto& [index, value] : record.changes)
+                {
+                    setParameter(index, value);
+                    changed.add(parameterIDs[index]);
+                }
+                callback.changes = changed.joinIntoString(",");
+
+                buffer.setSize(juce::jmax(record.numChannels, processor.getTotalNumOutputChannels()), callback.numSamples,
+                               false, false, true);
+                buffer.clear();
+                for (int c = 0; c < juce::jmin(record.numChannels, buffer.getNumChannels()); ++c)
+                    buffer.copyFrom(c, 0, record.input, c, 0, callback.numSamples);
+
+                if (settings.paced)
+                {
+                    const auto startTicks = juce::Time::secondsToHighResolutionTicks(callback.startSeconds);
+                    if (firstBlock)
+                        originTicks = juce::Time::getHighResolutionTicks() - startTicks;
+
+                    while (juce::Time::getHighResolutionTicks() < originTicks + startTicks)
+                        std::this_thread::yield();
+                }
+
+                firstBlock = false;
+                const auto callbackStart = juce::Time::getHighResolutionTicks();
+                processor.processBlock(buffer, midi);
+                callback.replayMicroseconds = 1.0e6 * juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - callbackStart);
+
+                report.callbacks.push_back(callback);
+                break;
+            }
+
+            case SessionCapture::RecordType::gap:
+                report.numDropped += record.numDropped;
+                break;
+
+            case SessionCapture::RecordType::end:
+                report.sizeLimited = record.endReason == SessionCapture::EndReason::sizeLimit;
+                break;
+        }
+    }
+
+    report.truncated = report.truncated || reader.isTruncated();
+    return juce::Result::ok();
+}
+
+void SessionReplay::prepare(const SessionReader::Record& record)
+{
+    for (size_t i = 0; i < record.values.size(); ++i)
+        setParameter((int) i, record.values[i]);
+
+    const auto layout = juce::AudioChannelSet::canonicalChannelSet(record.numChannels);
+    juce::AudioProcessor::BusesLayout buses;
+    buses.inputBuses.add(layout);
+    buses.outputBuses.add(layout);
+    processor.setBusesLayout(buses);
+
+    sampleRate = record.sampleRate;
+    processor.setRateAndBufferSizeDetails(record.sampleRate, record.blockSize);
+    processor.prepareToPlay(record.sampleRate, record.blockSize);
+}
+
+void SessionReplay::setParameter(int index, float value)
+{
+    if (index < 0 || index >= (int) parameters.size())
+        return;
+
+    if (auto* parameter = parameters[(size_t) index])
+        if (parameter->getValue() != value)
+            parameter->setValueNotifyingHost(value);
+}
+
+SessionReplay::Statistics SessionReplay::Report::getStatistics(double Callback::* time) const
+{
+    Statistics statistics;
+    if (callbacks.empty())
+        return statistics;
+
+    std::vector<double> times;
+    times.reserve(callbacks.size());
+    for (const auto& callback : callbacks)
+    {
+        times.push_back(callback.*time);
+        if (callback.*time > callback.budgetMicroseconds)
+            ++statistics.numMisses;
+    }
+
+    std::sort(times.begin(), times.end());
+    auto percentile = [&times](double fraction)
+    {
+        return times[juce::jmin(times.size() - 1, (size_t) (fraction * (double) times.size()))];
+    };
+
+    statistics.p50 = percentile(0.5);
+    statistics.p99 = percentile(0.99);
+    statistics.p999 = percentile(0.999);
+    statistics.max = times.back();
+    return statistics;
+}
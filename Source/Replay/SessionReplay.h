@@ -0,0 +1,81 @@
+#pragma once
+#include "../PluginProcessor.h"
+#include "SessionReader.h"
+
+/*
+  Drives an AudioPluginAudioProcessor through a session SessionCapture recorded: each
+  prepare record prepares it with the captured rate, block size, channels and parameter
+  values, and each block record sets the parameters that changed, as host automation
+  does, then calls processBlock on the captured input with the captured length. JUCE
+  gives the processor no offsets within a block, so the capture has none either: the
+  spectral parameters' changes are queued at the block's first sample, where they landed
+  live, and replay the same at any pace.
+
+  run() is the audio thread. The processor still posts its engine rebuilds to the message
+  thread, so whatever runs the message loop meanwhile plays the host's message thread.
+
+  Callbacks go back to back unless paced, in which case each one waits for the point
+  where it started in the captured session. Every callback's time is kept next to the
+  time it took live, and one that takes longer than its buffer's duration is a miss.
+ */
+class SessionReplay
+{
+public:
+    struct Settings
+    {
+        juce::File file;
+        int repeats = 1;
+        bool paced = false;
+    };
+
+    struct Callback
+    {
+        juce::int64 index = 0;
+        double startSeconds = 0.0;
+        int numSamples = 0;
+        double budgetMicroseconds = 0.0;
+        double liveMicroseconds = 0.0;
+        double replayMicroseconds = 0.0;
+        // IDs of the parameters that changed for this callback.
+        juce::String changes;
+    };
+
+    struct Statistics
+    {
+        double p50 = 0.0, p99 = 0.0, p999 = 0.0, max = 0.0;
+        juce::int64 numMisses = 0;
+    };
+
+    struct Report
+    {
+        std::vector<Callback> callbacks;
+        juce::int64 numPrepares = 0;
+        juce::int64 numDropped = 0;
+        bool truncated = false;
+        bool sizeLimited = false;
+        juce::StringArray unknownParameters;
+
+        // Over the live or the replayed times, in microseconds.
+        Statistics getStatistics(double Callback::* time) const;
+    };
+
+    explicit SessionReplay(const Settings& newSettings);
+
+    juce::Result run(Report& report);
+
+private:
+    juce::Result replayOnce(Report& report);
+    void prepare(const SessionReader::Record& record);
+    void setParameter(int index, float value);
+
+    Settings settings;
+    AudioPluginAudioProcessor processor;
+    // The processor's parameters in the order of the file's IDs, null where it has none.
+    std::vector<juce::AudioProcessorParameter*> parameters;
+    juce::StringArray parameterIDs;
+    juce::AudioBuffer<float> buffer;
+    juce::MidiBuffer midi;
+    double sampleRate = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SessionReplay)
+};
@@ -0,0 +1,192 @@
+#include "HostSimulation.h"
+
+namespace
+{
+    // Automating these rebuilds the engine or changes the latency, which a host only does
+    // when the user asks for it, not from a lane.
+    const juce::StringArray structuralParameters{"order", "size", "overlap", "stereo", "resolution", "batch", "oversampling", "bypass"};
+}
+
+HostSimulation::HostSimulation(const Settings& newSettings)
+    : settings(newSettings)
+{
+}
+
+HostSimulation::~HostSimulation()
+{
+    stopWorkers();
+}
+
+juce::Result HostSimulation::prepare()
+{
+    const auto layout = juce::AudioChannelSet::stereo();
+
+    for (int i = 0; i < settings.numInstances; ++i)
+    {
+        auto instance = std::make_unique<Instance>();
+        instance->processor = std::make_unique<AudioPluginAudioProcessor>();
+        auto& processor = *instance->processor;
+
+        for (const auto& parameterID : settings.parameters.getAllKeys())
+        {
+            const auto applied = processor.setParameterFromText(parameterID, settings.parameters[parameterID]);
+            if (applied.failed())
+                return applied;
+        }
+
+        juce::AudioProcessor::BusesLayout buses;
+        buses.inputBuses.add(layout);
+        buses.outputBuses.add(layout);
+        processor.setBusesLayout(buses);
+        processor.setRateAndBufferSizeDetails(settings.sampleRate, settings.blockSize);
+        processor.prepareToPlay(settings.sampleRate, settings.blockSize);
+
+        // Nothing runs a message loop here, so smear's history is built up front, as a
+        // host's message thread would once the automation first turned smear up.
+        processor.allocateSmearHistory();
+
+        instance->buffer.setSize(layout.size(), settings.blockSize);
+        instance->input.setSize(layout.size(), inputLength);
+        instance->random.setSeed(0x6b72757368 + i);
+        for (int c = 0; c < layout.size(); ++c)
+            for (int s = 0; s < inputLength; ++s)
+                instance->input.setSample(c, s, 0.25f * (instance->random.nextFloat() * 2.0f - 1.0f));
+
+        // Spread the instances over the input so they don't all see the same samples.
+        instance->inputPosition = instance->random.nextInt(inputLength / settings.blockSize) * settings.blockSize;
+
+        for (auto* parameter : processor.getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+                if (!structuralParameters.contains(ranged->getParameterID()))
+                    instance->automated.add(ranged);
+
+        instances.push_back(std::move(instance));
+    }
+
+    // Taken here rather than by the workers, which might start after the first callback.
+    const auto firstGeneration = generation.load();
+    stopping = false;
+    for (int w = 1; w < settings.numThreads; ++w)
+        workers.emplace_back([this, w, firstGeneration] { workerLoop(w, firstGeneration); });
+
+    return juce::Result::ok();
+}
+
+HostSimulation::Report HostSimulation::run()
+{
+    const auto numCallbacks = juce::jmax((juce::int64) 1, (juce::int64) (settings.seconds * settings.sampleRate / settings.blockSize));
+    const auto budgetSeconds = settings.blockSize / settings.sampleRate;
+
+    std::vector<double> times;
+    times.reserve((size_t) numCallbacks);
+
+    for (int i = 0; i < numWarmUpCallbacks; ++i)
+        renderCallback();
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    for (juce::int64 callback = 0; callback < numCallbacks; ++callback)
+    {
+        if (settings.paced)
+        {
+            const auto due = startTicks + juce::Time::secondsToHighResolutionTicks((double) callback * budgetSeconds);
+            while (juce::Time::getHighResolutionTicks() < due)
+                std::this_thread::yield();
+        }
+
+        const auto callbackStart = juce::Time::getHighResolutionTicks();
+        renderCallback();
+        times.push_back(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - callbackStart));
+    }
+
+    Report report;
+    report.budgetMs = budgetSeconds * 1000.0;
+    report.numCallbacks = numCallbacks;
+    report.numMisses = std::count_if(times.begin(), times.end(), [budgetSeconds](double time) { return time > budgetSeconds; });
+
+    std::sort(times.begin(), times.end());
+    auto percentile = [&times](double fraction)
+    {
+        return 1000.0 * times[juce::jmin(times.size() - 1, (size_t) (fraction * (double) times.size()))];
+    };
+
+    report.p50Ms = percentile(0.5);
+    report.p99Ms = percentile(0.99);
+    report.p999Ms = percentile(0.999);
+    report.maxMs = 1000.0 * times.back();
+    return report;
+}
+
+void HostSimulation::renderCallback()
+{
+    if (workers.empty())
+    {
+        processInstances(0);
+        return;
+    }
+
+    numPending = (int) workers.size();
+    generation.fetch_add(1, std::memory_order_release);
+
+    processInstances(0);
+
+    while (numPending.load(std::memory_order_acquire) > 0)
+        std::this_thread::yield();
+}
+
+void HostSimulation::processInstances(int worker)
+{
+    for (auto i = (size_t) worker; i < instances.size(); i += (size_t) settings.numThreads)
+        processInstance(*instances[i]);
+}
+
+void HostSimulation::processInstance(Instance& instance)
+{
+    const auto numChannels = instance.buffer.getNumChannels();
+    for (int c = 0; c < numChannels; ++c)
+        instance.buffer.copyFrom(c, 0, instance.input, c, instance.inputPosition, settings.blockSize);
+
+    instance.inputPosition += settings.blockSize;
+    if (instance.inputPosition + settings.blockSize > inputLength)
+        instance.inputPosition = 0;
+
+    // On average automationRate changes a second, each to a random value of a random parameter.
+    const auto changesThisBlock = settings.automationRate * settings.blockSize / settings.sampleRate;
+    auto numChanges = (int) changesThisBlock;
+    if (instance.random.nextDouble() < changesThisBlock - numChanges)
+        ++numChanges;
+
+    for (int change = 0; change < numChanges && !instance.automated.isEmpty(); ++change)
+    {
+        auto* parameter = instance.automated[instance.random.nextInt(instance.automated.size())];
+        parameter->setValueNotifyingHost(instance.random.nextFloat());
+    }
+
+    instance.processor->processBlock(instance.buffer, instance.midi);
+}
+
+void HostSimulation::workerLoop(int worker, juce::int64 seen)
+{
+    while (!stopping.load(std::memory_order_acquire))
+    {
+        const auto current = generation.load(std::memory_order_acquire);
+        if (current == seen)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        seen = current;
+        processInstances(worker);
+        numPending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+void HostSimulation::stopWorkers()
+{
+    stopping = true;
+    for (auto& worker : workers)
+        worker.join();
+
+    workers.clear();
+}
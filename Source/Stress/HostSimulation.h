@@ -0,0 +1,86 @@
+#pragma once
+#include "../PluginProcessor.h"
+#include <thread>
+
+/*
+  Plays host to a number of AudioPluginAudioProcessors at once, the way a DAW runs a
+  session: every instance is prepared for the same rate and buffer size, then each audio
+  callback fills every instance's buffer and calls its processBlock. With more than one
+  thread the instances are dealt out to worker threads that spin between callbacks, as a
+  host's audio workers do, and the callback is done when the last of them is.
+
+  Each instance gets its own seeded noise and random automation of the parameters that
+  don't rebuild the engine, set from the audio thread like host automation. No message
+  loop runs, so the one thing the processor leaves to the message thread for those,
+  smear's history, is built when the instance is prepared.
+
+  Callbacks run back to back unless paced, in which case each one waits for the point in
+  real time where its buffer would be due. A callback that takes longer than its
+  buffer's duration is a deadline miss.
+ */
+class HostSimulation
+{
+public:
+    struct Settings
+    {
+        int numInstances = 16;
+        double sampleRate = 48000.0;
+        int blockSize = 128;
+        int numThreads = 1;
+        double seconds = 10.0;
+        // Parameter changes per second, per instance.
+        double automationRate = 20.0;
+        bool paced = false;
+        // Parameter ID to value text, set on every instance before it is prepared.
+        juce::StringPairArray parameters;
+    };
+
+    struct Report
+    {
+        double budgetMs = 0.0;
+        double p50Ms = 0.0, p99Ms = 0.0, p999Ms = 0.0, maxMs = 0.0;
+        juce::int64 numCallbacks = 0;
+        juce::int64 numMisses = 0;
+
+        double getMissRate() const { return numCallbacks > 0 ? (double) numMisses / (double) numCallbacks : 0.0; }
+    };
+
+    explicit HostSimulation(const Settings& newSettings);
+    ~HostSimulation();
+
+    // Creates and prepares the instances.
+    juce::Result prepare();
+    Report run();
+
+private:
+    // The first callbacks fill caches and FIFOs and aren't counted.
+    static constexpr int numWarmUpCallbacks = 32;
+    static constexpr int inputLength = 1 << 16;
+
+    struct Instance
+    {
+        std::unique_ptr<AudioPluginAudioProcessor> processor;
+        juce::AudioBuffer<float> buffer;
+        juce::AudioBuffer<float> input;
+        juce::MidiBuffer midi;
+        juce::Random random;
+        juce::Array<juce::RangedAudioParameter*> automated;
+        int inputPosition = 0;
+    };
+
+    void renderCallback();
+    void processInstances(int worker);
+    void processInstance(Instance& instance);
+    void workerLoop(int worker, juce::int64 seen);
+    void stopWorkers();
+
+    Settings settings;
+    std::vector<std::unique_ptr<Instance>> instances;
+
+    std::vector<std::thread> workers;
+    std::atomic<juce::int64> generation{0};
+    std::atomic<int> numPending{0};
+    std::atomic<bool> stopping{false};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HostSimulation)
+};
@@ -0,0 +1,231 @@
+#include "HostSimulation.h"
+#include <iostream>
+#include <optional>
+
+/*
+  krush-stress: runs many Krush instances in one process, as a busy session would, and
+  reports how long the audio callbacks take against the time the host has for them.
+
+    krush-stress [options]
+
+  Every combination of the given rates and block sizes is run in turn. With --find-max
+  each combination instead searches for the most instances that stay under the miss
+  rate: doubling until a run fails, then bisecting between the last pass and the fail.
+
+  With KRUSH_TRACE set, every run goes on one Chrome trace of the audio thread.
+ */
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage: krush-stress [options]\n"
+                     "  -n, --instances <n>      instances to run (default: 16)\n"
+                     "  -r, --rate <list>        sample rates in Hz, as a,b,c (default: 48000)\n"
+                     "  -b, --block <list>       block sizes, 32 to 1024, as a,b,c (default: 128)\n"
+                     "  -j, --threads <n>        audio threads sharing the instances (default: 1)\n"
+                     "  -t, --seconds <s>        audio to simulate per run (default: 10)\n"
+                     "  -a, --automation <n>     parameter changes per second per instance (default: 20)\n"
+                     "  -s, --set <id>=<value>   set a parameter on every instance, can be repeated\n"
+                     "      --paced              wait for each callback's due time instead of\n"
+                     "                           running them back to back\n"
+                     "      --find-max           search for the most instances under --miss-rate\n"
+                     "      --miss-rate <r>      allowed fraction of missed deadlines (default: 0.001)\n"
+                     "\n"
+                     "Set KRUSH_TRACE to a file or directory to record a Chrome trace of the runs.\n";
+    }
+
+    juce::Array<double> parseList(const juce::String& list)
+    {
+        juce::StringArray tokens;
+        tokens.addTokens(list, ",", "");
+        tokens.trim();
+        tokens.removeEmptyStrings();
+
+        juce::Array<double> values;
+        for (const auto& token : tokens)
+            values.add(token.getDoubleValue());
+        return values;
+    }
+
+    bool runSimulation(const HostSimulation::Settings& settings, HostSimulation::Report& report)
+    {
+        HostSimulation simulation(settings);
+        const auto prepared = simulation.prepare();
+        if (prepared.failed())
+        {
+            std::cerr << prepared.getErrorMessage() << "\n";
+            return false;
+        }
+
+        report = simulation.run();
+        return true;
+    }
+
+    void printReport(const HostSimulation::Settings& settings, const HostSimulation::Report& report)
+    {
+        std::cout << juce::String(settings.sampleRate, 0) << " Hz, " << settings.blockSize << " samples, "
+                  << settings.numInstances << " instances: budget " << juce::String(report.budgetMs, 3)
+                  << " ms, p50 " << juce::String(report.p50Ms, 3) << ", p99 " << juce::String(report.p99Ms, 3)
+                  << ", p99.9 " << juce::String(report.p999Ms, 3) << ", max " << juce::String(report.maxMs, 3)
+                  << " ms, " << report.numMisses << " of " << report.numCallbacks << " deadlines missed ("
+                  << juce::String(100.0 * report.getMissRate(), 3) << "%)\n";
+    }
+
+    constexpr int searchLimit = 4096;
+
+    // The most instances whose run stays at or under maxMissRate, up to searchLimit, or 0
+    // if one doesn't. Nothing if a run couldn't be set up, which runSimulation has reported.
+    std::optional<int> findMaxInstances(HostSimulation::Settings settings, double maxMissRate)
+    {
+        HostSimulation::Report report;
+        auto setupFailed = false;
+        auto passes = [&](int numInstances)
+        {
+            settings.numInstances = numInstances;
+            if (!runSimulation(settings, report))
+            {
+                setupFailed = true;
+                return false;
+            }
+
+            printReport(settings, report);
+            return report.getMissRate() <= maxMissRate;
+        };
+
+        int passed = 0, failed = 1;
+        while (passes(failed))
+        {
+            passed = failed;
+            if (passed >= searchLimit)
+                return passed;
+
+            failed = juce::jmin(searchLimit, failed * 2);
+        }
+
+        if (setupFailed)
+            return std::nullopt;
+
+        while (failed - passed > 1)
+        {
+            const auto middle = passed + (failed - passed) / 2;
+            if (passes(middle))
+                passed = middle;
+            else
+                failed = middle;
+
+            if (setupFailed)
+                return std::nullopt;
+        }
+
+        return passed;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+   #if KRUSH_INSTRUMENTATION
+    // Held for the whole session, so the runs share one trace instead of each starting a new file.
+    const juce::SharedResourcePointer<TraceRecorder> traceRecorder;
+   #endif
+
+    HostSimulation::Settings settings;
+    juce::Array<double> sampleRates{48000.0};
+    juce::Array<double> blockSizes{128.0};
+    auto findMax = false;
+    auto maxMissRate = 0.001;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        const auto hasValue = i + 1 < argc;
+        auto value = [&] { return juce::String(argv[++i]); };
+
+        if ((arg == "-n" || arg == "--instances") && hasValue)
+            settings.numInstances = juce::jmax(1, value().getIntValue());
+        else if ((arg == "-r" || arg == "--rate") && hasValue)
+            sampleRates = parseList(value());
+        else if ((arg == "-b" || arg == "--block") && hasValue)
+            blockSizes = parseList(value());
+        else if ((arg == "-j" || arg == "--threads") && hasValue)
+            settings.numThreads = juce::jmax(1, value().getIntValue());
+        else if ((arg == "-t" || arg == "--seconds") && hasValue)
+            settings.seconds = juce::jmax(0.1, value().getDoubleValue());
+        else if ((arg == "-a" || arg == "--automation") && hasValue)
+            settings.automationRate = juce::jmax(0.0, value().getDoubleValue());
+        else if ((arg == "-s" || arg == "--set") && hasValue)
+        {
+            const auto assignment = value();
+            settings.parameters.set(assignment.upToFirstOccurrenceOf("=", false, false).trim(),
+                                    assignment.fromFirstOccurrenceOf("=", false, false).trim());
+        }
+        else if (arg == "--paced")
+            settings.paced = true;
+        else if (arg == "--find-max")
+            findMax = true;
+        else if (arg == "--miss-rate" && hasValue)
+            maxMissRate = juce::jlimit(0.0, 1.0, value().getDoubleValue());
+        else if (arg == "-h" || arg == "--help")
+        {
+            printUsage();
+            return 0;
+        }
+        else
+        {
+            std::cerr << "Unknown option " << arg << "\n";
+            printUsage();
+            return 2;
+        }
+    }
+
+    for (auto rate : sampleRates)
+    {
+        if (rate < 8000.0 || rate > 384000.0)
+        {
+            std::cerr << "Unsupported sample rate " << rate << "\n";
+            return 2;
+        }
+    }
+
+    for (auto block : blockSizes)
+    {
+        if (block < 32.0 || block > 1024.0)
+        {
+            std::cerr << "Block sizes must be between 32 and 1024\n";
+            return 2;
+        }
+    }
+
+    std::cout << settings.numThreads << " audio thread(s), " << (settings.paced ? "paced" : "back to back") << ", "
+              << settings.automationRate << " parameter changes per second per instance\n";
+
+    for (auto rate : sampleRates)
+    {
+        for (auto block : blockSizes)
+        {
+            settings.sampleRate = rate;
+            settings.blockSize = (int) block;
+
+            if (findMax)
+            {
+                const auto maxInstances = findMaxInstances(settings, maxMissRate);
+                if (!maxInstances.has_value())
+                    return 2;
+
+                std::cout << juce::String(rate, 0) << " Hz, " << settings.blockSize << " samples: at most "
+                          << *maxInstances << " instances under " << juce::String(100.0 * maxMissRate, 3)
+                          << "% missed deadlines\n";
+                continue;
+            }
+
+            HostSimulation::Report report;
+            if (!runSimulation(settings, report))
+                return 2;
+
+            printReport(settings, report);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <juce_core/juce_core.h>
+
+/*
+  A parameter change that should take effect at a given input sample.
+ */
+struct ParameterEvent
+{
+    juce::int64 samplePosition = 0;
+    int parameter = 0;
+    float value = 0.0f;
+};
+
+/*
+  Bounded lock-free queue of ParameterEvents. Any number of threads may push (host
+  automation arrives on the audio thread, the editor's changes on the message thread);
+  only the audio thread pops. Each slot carries a sequence number saying whether it is
+  free, being written or ready, so producers never wait on each other or on the consumer.
+  All the storage is allocated up front.
+ */
+class ParameterEventQueue
+{
+public:
+    explicit ParameterEventQueue(int capacity)
+        : slots((size_t) juce::nextPowerOfTwo(capacity)), mask((juce::int64) slots.size() - 1)
+    {
+        for (size_t i = 0; i < slots.size(); ++i)
+            slots[i].sequence.store((juce::int64) i, std::memory_order_relaxed);
+    }
+
+    // Returns false, dropping the event, if the queue is full.
+    bool push(const ParameterEvent& event)
+    {
+        auto position = writePosition.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            auto& slot = slots[(size_t) (position & mask)];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+
+            if (sequence == position)
+            {
+                if (writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    slot.event = event;
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (sequence < position)
+            {
+                return false;
+            }
+            else
+            {
+                position = writePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Pops, in order, every event due at or before samplePosition. Stops at the first one
+    // that's still in the future, so events must be pushed in order of their positions.
+    template <typename FApply>
+    void popUntil(juce::int64 samplePosition, FApply&& apply)
+    {
+        for (;;)
+        {
+            auto& slot = slots[(size_t) (readPosition & mask)];
+            if (slot.sequence.load(std::memory_order_acquire) != readPosition + 1
+                || slot.event.samplePosition > samplePosition)
+                return;
+
+            apply(slot.event);
+            slot.sequence.store(readPosition + (juce::int64) slots.size(), std::memory_order_release);
+            ++readPosition;
+        }
+    }
+
+    // Where the next event is due, or the largest position there is if none is waiting.
+    juce::int64 getNextPosition() const
+    {
+        const auto& slot = slots[(size_t) (readPosition & mask)];
+        if (slot.sequence.load(std::memory_order_acquire) != readPosition + 1)
+            return std::numeric_limits<juce::int64>::max();
+
+        return slot.event.samplePosition;
+    }
+
+    void clear()
+    {
+        popUntil(std::numeric_limits<juce::int64>::max(), [](const ParameterEvent&) {});
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<juce::int64> sequence{0};
+        ParameterEvent event;
+    };
+
+    std::vector<Slot> slots;
+    const juce::int64 mask;
+    std::atomic<juce::int64> writePosition{0};
+    juce::int64 readPosition = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParameterEventQueue)
+};
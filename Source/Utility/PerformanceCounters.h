@@ -0,0 +1,173 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include "TraceRecorder.h"
+
+// Set to 1 by the plugin's build; anything else that includes the DSP headers gets none
+// of the timing code.
+#ifndef KRUSH_INSTRUMENTATION
+ #define KRUSH_INSTRUMENTATION 0
+#endif
+
+/*
+  Where the audio thread's time goes, for the editor's performance overlay.
+
+  The audio thread adds the high resolution ticks spent in each stage over a block, then
+  endBlock() publishes them with the block's total time, the hops it ran and its share
+  of the real-time budget. The published values are relaxed atomics with a single writer,
+  so the editor can read them at any time without locks; a snapshot may mix two
+  neighbouring blocks, which is fine for a meter.
+
+  The worst callback is kept until the editor asks for it to be reset, which the audio
+  thread does at its next block so it stays the only writer.
+
+  Time a stage with KRUSH_TIME_STAGE(counters, stage), which compiles to nothing unless
+  KRUSH_INSTRUMENTATION is set, and takes a null pointer when nothing is listening. With
+  a TraceRecorder attached, each timed stage is also a begin and end event on the trace.
+ */
+class PerformanceCounters
+{
+public:
+    // Window covers capturing frames and overlap-adding them; mix is mid/side, the dry
+    // delay and the mix; gain is the oversampled gain stage.
+    enum class Stage { window, forward, spectral, inverse, mix, gain, numStages };
+    static constexpr int numStages = (int) Stage::numStages;
+
+    static const char* getStageName(Stage stage)
+    {
+        static constexpr std::array<const char*, numStages> names{"Window", "Forward FFT", "Spectral", "Inverse FFT",
+                                                                  "Mix", "Gain"};
+        return names[(size_t) stage];
+    }
+
+    struct Snapshot
+    {
+        std::array<double, numStages> stageMicroseconds{};
+        double callbackMicroseconds = 0.0;
+        double worstMicroseconds = 0.0;
+        double budgetPercent = 0.0;
+        double worstBudgetPercent = 0.0;
+        int hopsPerBlock = 0;
+        juce::int64 numBlocks = 0;
+    };
+
+    class ScopedStage
+    {
+    public:
+        ScopedStage(PerformanceCounters* countersToUse, Stage stageToTime)
+            : counters(countersToUse), stage(stageToTime),
+              start(counters != nullptr ? juce::Time::getHighResolutionTicks() : 0)
+        {
+            if (counters != nullptr && counters->tracer != nullptr)
+                counters->tracer->record(getStageName(stage), TraceRecorder::Phase::begin, start, counters->traceInstance);
+        }
+
+        ~ScopedStage()
+        {
+            if (counters == nullptr)
+                return;
+
+            const auto end = juce::Time::getHighResolutionTicks();
+            counters->addStageTicks(stage, end - start);
+            if (counters->tracer != nullptr)
+                counters->tracer->record(getStageName(stage), TraceRecorder::Phase::end, end, counters->traceInstance);
+        }
+
+    private:
+        PerformanceCounters* counters;
+        Stage stage;
+        juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedStage)
+    };
+
+    // Audio thread.
+    void beginBlock()
+    {
+        blockStart = juce::Time::getHighResolutionTicks();
+    }
+
+    void addStageTicks(Stage stage, juce::int64 ticks) { pendingTicks[(size_t) stage] += ticks; }
+    void addHop() { ++pendingHops; }
+
+    void endBlock(int numSamples, double sampleRate)
+    {
+        const auto callbackMicroseconds = toMicroseconds(juce::Time::getHighResolutionTicks() - blockStart);
+        const auto budgetMicroseconds = sampleRate > 0.0 ? 1.0e6 * numSamples / sampleRate : 0.0;
+        const auto budgetPercent = budgetMicroseconds > 0.0 ? 100.0 * callbackMicroseconds / budgetMicroseconds : 0.0;
+
+        if (worstResetRequested.exchange(false, std::memory_order_relaxed) || callbackMicroseconds > worstMicroseconds)
+        {
+            worstMicroseconds = callbackMicroseconds;
+            worstBudgetPercent = budgetPercent;
+            publishedWorst.store(worstMicroseconds, std::memory_order_relaxed);
+            publishedWorstBudget.store(worstBudgetPercent, std::memory_order_relaxed);
+        }
+
+        for (size_t s = 0; s < (size_t) numStages; ++s)
+        {
+            publishedStages[s].store(toMicroseconds(pendingTicks[s]), std::memory_order_relaxed);
+            pendingTicks[s] = 0;
+        }
+
+        publishedCallback.store(callbackMicroseconds, std::memory_order_relaxed);
+        publishedBudget.store(budgetPercent, std::memory_order_relaxed);
+        publishedHops.store(pendingHops, std::memory_order_relaxed);
+        publishedBlocks.fetch_add(1, std::memory_order_relaxed);
+        pendingHops = 0;
+    }
+
+    // Any thread.
+    Snapshot getSnapshot() const
+    {
+        Snapshot snapshot;
+        for (size_t s = 0; s < (size_t) numStages; ++s)
+            snapshot.stageMicroseconds[s] = publishedStages[s].load(std::memory_order_relaxed);
+
+        snapshot.callbackMicroseconds = publishedCallback.load(std::memory_order_relaxed);
+        snapshot.worstMicroseconds = publishedWorst.load(std::memory_order_relaxed);
+        snapshot.budgetPercent = publishedBudget.load(std::memory_order_relaxed);
+        snapshot.worstBudgetPercent = publishedWorstBudget.load(std::memory_order_relaxed);
+        snapshot.hopsPerBlock = publishedHops.load(std::memory_order_relaxed);
+        snapshot.numBlocks = publishedBlocks.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    void resetWorst() { worstResetRequested.store(true, std::memory_order_relaxed); }
+
+    // Before processing starts; null stops the stages going on the trace.
+    void setTraceRecorder(TraceRecorder* recorder, int instance)
+    {
+        tracer = recorder;
+        traceInstance = instance;
+    }
+
+private:
+    static double toMicroseconds(juce::int64 ticks)
+    {
+        return 1.0e6 * juce::Time::highResolutionTicksToSeconds(ticks);
+    }
+
+    // Audio thread only.
+    std::array<juce::int64, numStages> pendingTicks{};
+    int pendingHops = 0;
+    juce::int64 blockStart = 0;
+    double worstMicroseconds = 0.0;
+    double worstBudgetPercent = 0.0;
+
+    std::array<std::atomic<double>, numStages> publishedStages{};
+    std::atomic<double> publishedCallback{0.0}, publishedWorst{0.0};
+    std::atomic<double> publishedBudget{0.0}, publishedWorstBudget{0.0};
+    std::atomic<int> publishedHops{0};
+    std::atomic<juce::int64> publishedBlocks{0};
+    std::atomic<bool> worstResetRequested{false};
+
+    TraceRecorder* tracer = nullptr;
+    int traceInstance = 0;
+};
+
+#if KRUSH_INSTRUMENTATION
+ #define KRUSH_TIME_STAGE(counters, stage) \
+    const PerformanceCounters::ScopedStage JUCE_JOIN_MACRO(krushStageTimer, __LINE__)(counters, PerformanceCounters::Stage::stage)
+#else
+ #define KRUSH_TIME_STAGE(counters, stage)
+#endif
@@ -0,0 +1,237 @@
+#include "SessionCapture.h"
+
+std::unique_ptr<SessionCapture> SessionCapture::create(int instanceID, const juce::Array<juce::AudioProcessorParameter*>& parameters)
+{
+    const auto path = juce::SystemStats::getEnvironmentVariable(environmentVariable, {});
+    if (path.isEmpty())
+        return nullptr;
+
+    const auto directory = juce::File::getCurrentWorkingDirectory().getChildFile(path);
+    if (directory.createDirectory().failed())
+        return nullptr;
+
+    auto megabytes = juce::SystemStats::getEnvironmentVariable(limitEnvironmentVariable, {}).getLargeIntValue();
+    if (megabytes <= 0)
+        megabytes = defaultLimitMegabytes;
+
+    const auto name = "krush-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + "-" + juce::String(instanceID) + ".kcap";
+    const auto fileToWrite = directory.getChildFile(name).getNonexistentSibling();
+
+    auto stream = std::make_unique<juce::FileOutputStream>(fileToWrite);
+    if (stream->failedToOpen())
+        return nullptr;
+
+    return std::unique_ptr<SessionCapture>(new SessionCapture(fileToWrite, std::move(stream), megabytes << 20, parameters));
+}
+
+SessionCapture::SessionCapture(const juce::File& fileToWrite, std::unique_ptr<juce::FileOutputStream> stream,
+                               juce::int64 limitBytes, const juce::Array<juce::AudioProcessorParameter*>& parametersToWatch)
+    : juce::Thread("Krush session capture"),
+      file(fileToWrite), output(std::move(stream)), limit(limitBytes),
+      startTicks(juce::Time::getHighResolutionTicks()), parameters(parametersToWatch),
+      lastValues((size_t) parametersToWatch.size()), ring(ringBytes)
+{
+    changes.reserve((size_t) parameters.size());
+
+    output->writeInt((int) magicNumber);
+    output->writeInt((int) formatVersion);
+    output->writeInt(parameters.size());
+
+    for (int i = 0; i < parameters.size(); ++i)
+    {
+        auto parameterID = juce::String(i);
+        if (auto* hosted = dynamic_cast<juce::HostedAudioProcessorParameter*>(parameters[i]))
+            parameterID = hosted->getParameterID();
+
+        const auto utf8 = parameterID.toUTF8();
+        const auto length = (int) utf8.sizeInBytes() - 1;
+        output->writeShort((short) length);
+        output->write(utf8.getAddress(), (size_t) length);
+    }
+
+    bytesCommitted = output->getPosition();
+    startThread(juce::Thread::Priority::low);
+}
+
+SessionCapture::~SessionCapture()
+{
+    stopThread(2000);
+    drain();
+
+    if (capturing)
+    {
+        output->writeByte((char) RecordType::end);
+        output->writeByte((char) EndReason::closed);
+    }
+
+    output->flush();
+}
+
+void SessionCapture::writePrepare(double sampleRate, int blockSize, int numChannels)
+{
+    if (!capturing)
+        return;
+
+    // Not the audio thread, so it can wait for the writer to make room.
+    while (head.load(std::memory_order_acquire) != tail.load(std::memory_order_acquire) && isThreadRunning())
+        juce::Thread::sleep(1);
+
+    const auto numBytes = 1 + sizeof(double) + 2 * sizeof(juce::int32) + lastValues.size() * sizeof(float);
+    if (!reserve(numBytes))
+        return;
+
+    put(RecordType::prepare);
+    put(sampleRate);
+    put((juce::int32) blockSize);
+    put((juce::int32) numChannels);
+
+    for (size_t i = 0; i < lastValues.size(); ++i)
+    {
+        lastValues[i] = parameters[(int) i]->getValue();
+        put(lastValues[i]);
+    }
+
+    commit();
+}
+
+void SessionCapture::beginBlock(const juce::AudioBuffer<float>& buffer, int numChannels)
+{
+    if (!capturing)
+        return;
+
+    blockStartTicks = juce::Time::getHighResolutionTicks();
+
+    changes.clear();
+    for (size_t i = 0; i < lastValues.size(); ++i)
+    {
+        const auto value = parameters[(int) i]->getValue();
+        if (value != lastValues[i])
+            changes.emplace_back((juce::uint16) i, value);
+    }
+
+    const auto numSamples = buffer.getNumSamples();
+    numChannels = juce::jmin(numChannels, buffer.getNumChannels());
+
+    const auto gapBytes = numDropped > 0 ? 1 + sizeof(juce::uint32) : 0;
+    const auto blockBytes = 1 + sizeof(double) + sizeof(float) + sizeof(juce::int32) + 2 * sizeof(juce::uint16)
+                            + changes.size() * (sizeof(juce::uint16) + sizeof(float))
+                            + (size_t) (numChannels * numSamples) * sizeof(float);
+
+    if (!reserve(gapBytes + blockBytes))
+    {
+        // The changes stay unrecorded, so the next block that fits carries them.
+        if (capturing)
+            ++numDropped;
+        return;
+    }
+
+    if (numDropped > 0)
+    {
+        put(RecordType::gap);
+        put(numDropped);
+        numDropped = 0;
+    }
+
+    put(RecordType::block);
+    put(1.0e6 * juce::Time::highResolutionTicksToSeconds(blockStartTicks - startTicks));
+    liveTimePosition = cursor;
+    put(0.0f);
+    put((juce::int32) numSamples);
+    put((juce::uint16) numChannels);
+    put((juce::uint16) changes.size());
+
+    for (const auto& [index, value] : changes)
+    {
+        put(index);
+        put(value);
+        lastValues[index] = value;
+    }
+
+    for (int c = 0; c < numChannels; ++c)
+        put(buffer.getReadPointer(c), (size_t) numSamples * sizeof(float));
+
+    blockOpen = true;
+}
+
+void SessionCapture::endBlock()
+{
+    if (!blockOpen)
+        return;
+
+    const auto microseconds = (float) (1.0e6 * juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - blockStartTicks));
+    patch(liveTimePosition, &microseconds, sizeof(float));
+    commit();
+    blockOpen = false;
+}
+
+bool SessionCapture::reserve(size_t numBytes)
+{
+    if (bytesCommitted + (juce::int64) (numBytes + endRecordBytes) > limit)
+    {
+        writeEnd(EndReason::sizeLimit);
+        return false;
+    }
+
+    // Room for the end record is always kept back.
+    cursor = head.load(std::memory_order_relaxed);
+    const auto used = cursor - tail.load(std::memory_order_acquire);
+    return used + numBytes + endRecordBytes <= ring.size();
+}
+
+void SessionCapture::put(const void* data, size_t numBytes)
+{
+    patch(cursor, data, numBytes);
+    cursor += numBytes;
+}
+
+void SessionCapture::patch(juce::uint64 position, const void* data, size_t numBytes)
+{
+    const auto offset = (size_t) (position % ring.size());
+    const auto first = juce::jmin(numBytes, ring.size() - offset);
+
+    std::memcpy(ring.data() + offset, data, first);
+    std::memcpy(ring.data(), static_cast<const char*>(data) + first, numBytes - first);
+}
+
+void SessionCapture::commit()
+{
+    bytesCommitted += (juce::int64) (cursor - head.load(std::memory_order_relaxed));
+    head.store(cursor, std::memory_order_release);
+}
+
+void SessionCapture::writeEnd(EndReason reason)
+{
+    capturing = false;
+    cursor = head.load(std::memory_order_relaxed);
+    put(RecordType::end);
+    put(reason);
+    commit();
+}
+
+void SessionCapture::run()
+{
+    while (!threadShouldExit())
+    {
+        drain();
+        wait(flushIntervalMs);
+    }
+}
+
+void SessionCapture::drain()
+{
+    const auto end = head.load(std::memory_order_acquire);
+    auto position = tail.load(std::memory_order_relaxed);
+    if (position == end)
+        return;
+
+    while (position < end)
+    {
+        const auto offset = (size_t) (position % ring.size());
+        const auto chunk = juce::jmin((size_t) (end - position), ring.size() - offset);
+        output->write(ring.data() + offset, chunk);
+        position += chunk;
+    }
+
+    tail.store(position, std::memory_order_release);
+    output->flush();
+}
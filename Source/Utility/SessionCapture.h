@@ -0,0 +1,107 @@
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+
+// Set to 1 by the plugin's build; with it, setting KRUSH_CAPTURE records what every
+// instance's processBlock sees for krush-replay.
+#ifndef KRUSH_SESSION_CAPTURE
+ #define KRUSH_SESSION_CAPTURE 0
+#endif
+
+/*
+  Records one processor's session as the host drives it, so krush-replay can run the
+  same callbacks again offline: every prepareToPlay with the sample rate, block size,
+  channel count and all the parameter values, then every processBlock with its input,
+  its length, the parameters that changed since the last one, when it started and how
+  long it took.
+
+  Capturing is opt-in: create() only returns a capture when the KRUSH_CAPTURE
+  environment variable names a directory, where each instance writes its own
+  krush-<time>-<instance>.kcap. It stops at KRUSH_CAPTURE_LIMIT_MB megabytes, 512 by
+  default.
+
+  The audio thread never blocks or allocates. Records go into a preallocated ring that a
+  background thread drains to the file; a block that doesn't fit is dropped whole, its
+  parameter changes carried into the next one, and a gap record says how many went.
+
+  The file is little-endian: the magic and version, the parameter IDs, then records that
+  each start with a RecordType byte.
+
+    prepare: f64 sample rate, i32 block size, i32 channels, f32 value per parameter
+    block:   f64 start in microseconds since the capture began, f32 microseconds the
+             callback took, i32 samples, u16 channels, u16 changes, then (u16 parameter,
+             f32 value) per change and the input as f32 samples, channel by channel
+    gap:     u32 blocks dropped
+    end:     u8 EndReason; missing if the process died
+ */
+class SessionCapture : private juce::Thread
+{
+public:
+    enum class RecordType : juce::uint8 { prepare = 1, block, gap, end };
+    enum class EndReason : juce::uint8 { closed, sizeLimit };
+
+    static constexpr juce::uint32 magicNumber = 0x5041434b; // "KCAP"
+    static constexpr juce::uint32 formatVersion = 1;
+    static constexpr const char* environmentVariable = "KRUSH_CAPTURE";
+    static constexpr const char* limitEnvironmentVariable = "KRUSH_CAPTURE_LIMIT_MB";
+    static constexpr juce::int64 defaultLimitMegabytes = 512;
+
+    // A capture for this instance if KRUSH_CAPTURE asks for one, otherwise nullptr.
+    static std::unique_ptr<SessionCapture> create(int instanceID, const juce::Array<juce::AudioProcessorParameter*>& parameters);
+
+    ~SessionCapture() override;
+
+    // From prepareToPlay, which the host never runs alongside processBlock.
+    void writePrepare(double sampleRate, int blockSize, int numChannels);
+
+    // Audio thread: at the very start of processBlock, before the buffer is touched, and
+    // at the very end.
+    void beginBlock(const juce::AudioBuffer<float>& buffer, int numChannels);
+    void endBlock();
+
+    const juce::File& getFile() const { return file; }
+
+private:
+    static constexpr size_t ringBytes = 8 << 20;
+    static constexpr int flushIntervalMs = 20;
+    static constexpr size_t endRecordBytes = 2;
+
+    SessionCapture(const juce::File& fileToWrite, std::unique_ptr<juce::FileOutputStream> stream,
+                   juce::int64 limitBytes, const juce::Array<juce::AudioProcessorParameter*>& parameters);
+
+    void run() override;
+    void drain();
+
+    // Producer side of the ring: reserve room for a whole record, put its bytes, then
+    // commit it for the writer thread.
+    bool reserve(size_t numBytes);
+    void put(const void* data, size_t numBytes);
+    template <typename Value>
+    void put(Value value) { put(&value, sizeof(Value)); }
+    void patch(juce::uint64 position, const void* data, size_t numBytes);
+    void commit();
+
+    void writeEnd(EndReason reason);
+
+    juce::File file;
+    std::unique_ptr<juce::FileOutputStream> output;
+    juce::int64 limit;
+    juce::int64 startTicks;
+
+    juce::Array<juce::AudioProcessorParameter*> parameters;
+    std::vector<float> lastValues;
+    std::vector<std::pair<juce::uint16, float>> changes;
+
+    std::vector<char> ring;
+    std::atomic<juce::uint64> head{0}, tail{0};
+
+    // Audio thread only.
+    juce::uint64 cursor = 0;
+    juce::int64 bytesCommitted = 0;
+    juce::uint64 liveTimePosition = 0;
+    juce::int64 blockStartTicks = 0;
+    juce::uint32 numDropped = 0;
+    bool blockOpen = false;
+    bool capturing = true;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SessionCapture)
+};
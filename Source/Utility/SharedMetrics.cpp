@@ -0,0 +1,148 @@
+#include "SharedMetrics.h"
+
+#if JUCE_LINUX || JUCE_BSD || JUCE_MAC
+ #include <cerrno>
+ #include <fcntl.h>
+ #include <signal.h>
+ #include <sys/mman.h>
+ #include <unistd.h>
+ #define KRUSH_POSIX_SHARED_MEMORY 1
+#else
+ #define KRUSH_POSIX_SHARED_MEMORY 0
+#endif
+
+#if JUCE_LINUX
+ #define KRUSH_SHARED_MEMORY_REGISTRY 0
+#else
+ #define KRUSH_SHARED_MEMORY_REGISTRY KRUSH_POSIX_SHARED_MEMORY
+#endif
+
+SharedMetricsSegment::SharedMetricsSegment(const juce::String& segmentName, SharedMetrics* mapped, bool isOwner)
+    : name(segmentName), metrics(mapped), owner(isOwner)
+{
+}
+
+SharedMetricsSegment::~SharedMetricsSegment()
+{
+   #if KRUSH_POSIX_SHARED_MEMORY
+    ::munmap(metrics, sizeof(SharedMetrics));
+    if (owner)
+        remove(name);
+   #endif
+}
+
+std::unique_ptr<SharedMetricsSegment> SharedMetricsSegment::create(int instanceID)
+{
+   #if KRUSH_POSIX_SHARED_MEMORY
+    const auto enabled = juce::SystemStats::getEnvironmentVariable(environmentVariable, {});
+    if (enabled.isEmpty() || enabled == "0")
+        return nullptr;
+
+    const auto processID = (int) ::getpid();
+    const auto segmentName = namePrefix + juce::String(processID) + "." + juce::String(instanceID);
+    const auto path = "/" + segmentName;
+
+    const auto fd = ::shm_open(path.toRawUTF8(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0)
+        return nullptr;
+
+    void* mapped = MAP_FAILED;
+    if (::ftruncate(fd, (off_t) sizeof(SharedMetrics)) == 0)
+        mapped = ::mmap(nullptr, sizeof(SharedMetrics), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        ::shm_unlink(path.toRawUTF8());
+        return nullptr;
+    }
+
+    auto* metrics = new (mapped) SharedMetrics();
+    metrics->processID = processID;
+    metrics->instanceID = instanceID;
+    metrics->magic.store(SharedMetrics::magicNumber, std::memory_order_release);
+
+   #if KRUSH_SHARED_MEMORY_REGISTRY
+    if (getRegistryDirectory().createDirectory().wasOk())
+        getRegistryDirectory().getChildFile(segmentName).create();
+   #endif
+
+    return std::unique_ptr<SharedMetricsSegment>(new SharedMetricsSegment(segmentName, metrics, true));
+   #else
+    juce::ignoreUnused(instanceID);
+    return nullptr;
+   #endif
+}
+
+std::unique_ptr<SharedMetricsSegment> SharedMetricsSegment::open(const juce::String& segmentName)
+{
+   #if KRUSH_POSIX_SHARED_MEMORY
+    const auto fd = ::shm_open(("/" + segmentName).toRawUTF8(), O_RDONLY, 0);
+    if (fd < 0)
+        return nullptr;
+
+    auto* mapped = ::mmap(nullptr, sizeof(SharedMetrics), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+        return nullptr;
+
+    // Only ever read through const references, so the read only mapping is never written.
+    auto* metrics = static_cast<SharedMetrics*>(mapped);
+    if (metrics->magic.load(std::memory_order_acquire) != SharedMetrics::magicNumber
+        || metrics->version != SharedMetrics::layoutVersion)
+    {
+        ::munmap(mapped, sizeof(SharedMetrics));
+        return nullptr;
+    }
+
+    return std::unique_ptr<SharedMetricsSegment>(new SharedMetricsSegment(segmentName, metrics, false));
+   #else
+    juce::ignoreUnused(segmentName);
+    return nullptr;
+   #endif
+}
+
+juce::StringArray SharedMetricsSegment::findAll()
+{
+    juce::StringArray names;
+   #if KRUSH_SHARED_MEMORY_REGISTRY
+    const auto directory = getRegistryDirectory();
+   #else
+    const juce::File directory("/dev/shm");
+   #endif
+    if (!directory.isDirectory())
+        return names;
+
+    for (const auto& file : directory.findChildFiles(juce::File::findFiles, false, juce::String(namePrefix) + "*"))
+        names.add(file.getFileName());
+
+    names.sort(true);
+    return names;
+}
+
+bool SharedMetricsSegment::isOwnerAlive() const
+{
+   #if KRUSH_POSIX_SHARED_MEMORY
+    return ::kill((pid_t) metrics->processID, 0) == 0 || errno == EPERM;
+   #else
+    return true;
+   #endif
+}
+
+void SharedMetricsSegment::remove(const juce::String& segmentName)
+{
+   #if KRUSH_POSIX_SHARED_MEMORY
+    ::shm_unlink(("/" + segmentName).toRawUTF8());
+   #else
+    juce::ignoreUnused(segmentName);
+   #endif
+   #if KRUSH_SHARED_MEMORY_REGISTRY
+    getRegistryDirectory().getChildFile(segmentName).deleteFile();
+   #endif
+}
+
+juce::File SharedMetricsSegment::getRegistryDirectory()
+{
+    // Not the temporary directory JUCE gives, which on macOS is per application.
+    return juce::File("/tmp/krush-metrics");
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <juce_core/juce_core.h>
+
+// Set to 1 by the plugin's build on POSIX systems, where each instance can publish its
+// metrics to shared memory for krush-top.
+#ifndef KRUSH_SHARED_METRICS
+ #define KRUSH_SHARED_METRICS 0
+#endif
+
+/*
+  One instance's metrics as they sit in shared memory. The processor is the only writer
+  and only ever stores, one relaxed atomic at a time, so the audio thread never waits;
+  readers in other processes may see one callback's update half applied, which the
+  counters tolerate since they only grow.
+
+  Callback times go into power of two buckets from under 16 us up, so a reader can
+  difference two readings and get the distribution over the interval in between.
+ */
+struct SharedMetrics
+{
+    static constexpr juce::uint32 magicNumber = 0x4b525348; // "KRSH"
+    static constexpr juce::uint32 layoutVersion = 1;
+    static constexpr int numBuckets = 16;
+    static constexpr double firstBucketMicroseconds = 16.0;
+
+    static_assert(std::atomic<juce::uint64>::is_always_lock_free, "shared counters have to be lock free");
+    static_assert(std::atomic<double>::is_always_lock_free, "shared counters have to be lock free");
+
+    // The bucket a callback of this length lands in; the last one takes everything longer.
+    static int getBucket(double microseconds)
+    {
+        auto bucket = 0;
+        for (auto limit = firstBucketMicroseconds; microseconds >= limit && bucket < numBuckets - 1; limit *= 2.0)
+            ++bucket;
+
+        return bucket;
+    }
+
+    static double getBucketLimitMicroseconds(int bucket) { return firstBucketMicroseconds * std::exp2(bucket); }
+
+    // Written once on creation; the magic goes last so a reader never sees half of it.
+    std::atomic<juce::uint32> magic{0};
+    juce::uint32 version = layoutVersion;
+    juce::int32 processID = 0;
+    juce::int32 instanceID = 0;
+
+    // What the engine is running, updated on prepare and whenever it changes.
+    std::atomic<double> sampleRate{0.0};
+    std::atomic<juce::int32> blockSize{0};
+    std::atomic<juce::int32> fftSize{0};
+    std::atomic<juce::int32> overlapOrder{0};
+    std::atomic<juce::int32> resolution{0};
+    std::atomic<juce::int32> batched{0};
+    std::atomic<juce::int32> oversampling{0};
+    std::atomic<juce::uint64> memoryBytes{0};
+
+    // Per callback.
+    std::atomic<juce::uint64> numCallbacks{0};
+    std::atomic<juce::uint64> numSamples{0};
+    std::atomic<juce::uint64> numDeadlineMisses{0};
+    std::atomic<double> totalMicroseconds{0.0};
+    std::atomic<double> maxMicroseconds{0.0};
+    std::array<std::atomic<juce::uint64>, numBuckets> buckets{};
+    std::atomic<juce::int64> lastCallbackMilliseconds{0};
+    std::atomic<juce::int32> inputSilent{0};
+    std::atomic<juce::int32> bypassed{0};
+
+    // Audio thread. Load and store, not read-modify-write, since there is one writer.
+    void recordCallback(double microseconds, int samples, double rate, bool silent, bool isBypassed)
+    {
+        auto increment = [](std::atomic<juce::uint64>& counter, juce::uint64 amount)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        };
+
+        increment(numCallbacks, 1);
+        increment(numSamples, (juce::uint64) samples);
+        increment(buckets[(size_t) getBucket(microseconds)], 1);
+        if (rate > 0.0 && microseconds > 1.0e6 * samples / rate)
+            increment(numDeadlineMisses, 1);
+
+        totalMicroseconds.store(totalMicroseconds.load(std::memory_order_relaxed) + microseconds, std::memory_order_relaxed);
+        if (microseconds > maxMicroseconds.load(std::memory_order_relaxed))
+            maxMicroseconds.store(microseconds, std::memory_order_relaxed);
+
+        lastCallbackMilliseconds.store(juce::Time::currentTimeMillis(), std::memory_order_relaxed);
+        inputSilent.store(silent ? 1 : 0, std::memory_order_relaxed);
+        bypassed.store(isBypassed ? 1 : 0, std::memory_order_relaxed);
+    }
+};
+
+/*
+  A SharedMetrics block in a POSIX shared memory object named /krush.<pid>.<instance>.
+  The creating instance unlinks it again when deleted; readers map it read only. Where
+  there is no POSIX shared memory, create() and open() return nullptr.
+
+  Publishing is opt-in: instances only create a segment while the KRUSH_METRICS
+  environment variable is set to anything but 0. Linux lists shared memory objects in
+  /dev/shm; elsewhere, macOS included, each segment also leaves an empty file of the same
+  name in /tmp/krush-metrics, and findAll() lists those.
+ */
+class SharedMetricsSegment
+{
+public:
+    static constexpr const char* namePrefix = "krush.";
+    static constexpr const char* environmentVariable = "KRUSH_METRICS";
+
+    ~SharedMetricsSegment();
+
+    // For the processor: a new, zeroed segment for this process and instance, or nullptr
+    // if KRUSH_METRICS isn't set.
+    static std::unique_ptr<SharedMetricsSegment> create(int instanceID);
+
+    // For readers: an existing segment, by name without the leading slash.
+    static std::unique_ptr<SharedMetricsSegment> open(const juce::String& name);
+
+    // The names of every segment that exists.
+    static juce::StringArray findAll();
+
+    // Whether the process that created the segment is still running.
+    bool isOwnerAlive() const;
+
+    // Unlinks a segment whose process has died without doing it.
+    static void remove(const juce::String& name);
+
+    SharedMetrics& getMetrics() { return *metrics; }
+    const SharedMetrics& getMetrics() const { return *metrics; }
+    const juce::String& getName() const { return name; }
+
+private:
+    SharedMetricsSegment(const juce::String& segmentName, SharedMetrics* mapped, bool isOwner);
+
+    // Where segments are listed on systems without /dev/shm.
+    static juce::File getRegistryDirectory();
+
+    juce::String name;
+    SharedMetrics* metrics;
+    bool owner;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedMetricsSegment)
+};
@@ -0,0 +1,183 @@
+#include "TraceRecorder.h"
+
+#if JUCE_WINDOWS
+ #include <process.h>
+#else
+ #include <unistd.h>
+#endif
+
+#if JUCE_LINUX || JUCE_BSD
+ #include <sys/syscall.h>
+#elif JUCE_MAC || JUCE_IOS
+ #include <pthread.h>
+#endif
+
+TraceRecorder::TraceRecorder()
+    : juce::Thread("Krush trace writer")
+{
+    const auto file = getOutputFile();
+    if (file == juce::File())
+        return;
+
+    auto stream = std::make_unique<juce::FileOutputStream>(file);
+    if (stream->failedToOpen() || !stream->setPosition(0) || stream->truncate().failed())
+    {
+        DBG("Can't write a trace to " + file.getFullPathName());
+        return;
+    }
+
+   #if JUCE_WINDOWS
+    processID = (juce::uint32) ::_getpid();
+   #else
+    processID = (juce::uint32) ::getpid();
+   #endif
+
+    slots.reset(new Slot[(size_t) ringSize]);
+    for (int i = 0; i < ringSize; ++i)
+        slots[(size_t) i].sequence.store((juce::uint64) i, std::memory_order_relaxed);
+
+    juce::String header;
+    header << "[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << (juce::int64) processID
+           << ",\"args\":{\"name\":\"Krush\"}}";
+    stream->writeText(header, false, false, nullptr);
+
+    output = std::move(stream);
+    startThread(juce::Thread::Priority::low);
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    if (output == nullptr)
+        return;
+
+    stopThread(1000);
+    drain();
+
+    juce::String footer;
+    if (const auto dropped = numDropped.load(); dropped > 0)
+        footer << ",\n{\"name\":\"Trace events dropped\",\"ph\":\"i\",\"s\":\"g\",\"ts\":"
+               << juce::String(1.0e6 * juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks()), 3)
+               << ",\"pid\":" << (juce::int64) processID << ",\"args\":{\"count\":" << dropped << "}}";
+
+    footer << "\n]\n";
+    output->writeText(footer, false, false, nullptr);
+    output->flush();
+}
+
+void TraceRecorder::record(const char* name, Phase phase, juce::int64 ticks, int instance) noexcept
+{
+    if (slots == nullptr)
+        return;
+
+    constexpr auto mask = (juce::uint64) ringSize - 1;
+    auto position = writePosition.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+
+    for (;;)
+    {
+        slot = &slots[(size_t) (position & mask)];
+        const auto sequence = slot->sequence.load(std::memory_order_acquire);
+
+        if (sequence == position)
+        {
+            if (writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (sequence < position)
+        {
+            // Still holding an event from the last time round, so the ring is full.
+            numDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            position = writePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->event.name = name;
+    slot->event.ticks = ticks;
+    slot->event.threadID = getThreadID();
+    slot->event.instance = instance;
+    slot->event.phase = phase;
+    slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+juce::File TraceRecorder::getOutputFile()
+{
+    const auto path = juce::SystemStats::getEnvironmentVariable(environmentVariable, {});
+    if (path.isEmpty())
+        return {};
+
+    const auto file = juce::File::getCurrentWorkingDirectory().getChildFile(path);
+    if (file.isDirectory())
+       #if JUCE_WINDOWS
+        return file.getChildFile("krush-" + juce::String((juce::int64) ::_getpid()) + ".json");
+       #else
+        return file.getChildFile("krush-" + juce::String((juce::int64) ::getpid()) + ".json");
+       #endif
+
+    return file;
+}
+
+juce::uint32 TraceRecorder::getThreadID() noexcept
+{
+    thread_local const auto threadID = []
+    {
+       #if JUCE_LINUX || JUCE_BSD
+        return (juce::uint32) ::syscall(SYS_gettid);
+       #elif JUCE_MAC || JUCE_IOS
+        juce::uint64 id = 0;
+        ::pthread_threadid_np(nullptr, &id);
+        return (juce::uint32) id;
+       #else
+        return (juce::uint32) (juce::pointer_sized_uint) juce::Thread::getCurrentThreadId();
+       #endif
+    }();
+
+    return threadID;
+}
+
+void TraceRecorder::run()
+{
+    while (!threadShouldExit())
+    {
+        drain();
+        wait(flushIntervalMs);
+    }
+}
+
+void TraceRecorder::drain()
+{
+    constexpr auto mask = (juce::uint64) ringSize - 1;
+    auto numWritten = 0;
+
+    for (;;)
+    {
+        auto& slot = slots[(size_t) (readPosition & mask)];
+        if (slot.sequence.load(std::memory_order_acquire) != readPosition + 1)
+            break;
+
+        writeEvent(slot.event);
+        slot.sequence.store(readPosition + (juce::uint64) ringSize, std::memory_order_release);
+        ++readPosition;
+        ++numWritten;
+    }
+
+    if (numWritten > 0)
+        output->flush();
+}
+
+void TraceRecorder::writeEvent(const Event& event)
+{
+    juce::String line;
+    line << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"" << juce::String::charToString((juce::juce_wchar) event.phase)
+         << "\",\"ts\":" << juce::String(1.0e6 * juce::Time::highResolutionTicksToSeconds(event.ticks), 3)
+         << ",\"pid\":" << (juce::int64) processID << ",\"tid\":" << (juce::int64) event.threadID;
+
+    if (event.phase == Phase::instant)
+        line << ",\"s\":\"t\"";
+
+    line << ",\"args\":{\"instance\":" << event.instance << "}}";
+    output->writeText(line, false, false, nullptr);
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <juce_core/juce_core.h>
+
+/*
+  Records begin and end events from the audio and message threads into a Chrome trace
+  event file, which chrome://tracing and Perfetto open as a timeline.
+
+  Recording is opt-in: it only runs when the KRUSH_TRACE environment variable names a
+  file, or a directory to write krush-<pid>.json into. Every processor in the process
+  holds the one recorder through a juce::SharedResourcePointer, so all instances land on
+  the same timeline, and the file is finished when the last of them goes.
+
+  record() takes no locks and never allocates: events go into a ring preallocated for
+  ringSize of them, claimed by compare-and-swap so any number of threads can write, and a
+  background thread drains it to the file every few milliseconds. When the ring is full
+  events are dropped and counted, and the count goes in the file. Names have to be string
+  literals, since only the pointer is stored.
+
+  Timestamps come from juce::Time::getHighResolutionTicks() and thread IDs are the
+  operating system's, so on Linux the events line up with a system trace taken alongside.
+  The file uses the array format, which the viewers still open if the process dies
+  before closing it.
+ */
+class TraceRecorder : private juce::Thread
+{
+public:
+    enum class Phase : char { begin = 'B', end = 'E', instant = 'i' };
+
+    TraceRecorder();
+    ~TraceRecorder() override;
+
+    bool isRecording() const { return output != nullptr; }
+
+    // Any thread.
+    void record(const char* name, Phase phase, juce::int64 ticks, int instance) noexcept;
+    void record(const char* name, Phase phase, int instance) noexcept
+    {
+        record(name, phase, juce::Time::getHighResolutionTicks(), instance);
+    }
+
+    // Begin and end events around a scope, with a null recorder doing nothing.
+    class Scope
+    {
+    public:
+        Scope(TraceRecorder* recorderToUse, const char* scopeName, int scopeInstance)
+            : recorder(recorderToUse), name(scopeName), instance(scopeInstance)
+        {
+            if (recorder != nullptr)
+                recorder->record(name, Phase::begin, instance);
+        }
+
+        ~Scope()
+        {
+            if (recorder != nullptr)
+                recorder->record(name, Phase::end, instance);
+        }
+
+    private:
+        TraceRecorder* recorder;
+        const char* name;
+        int instance;
+
+        JUCE_DECLARE_NON_COPYABLE(Scope)
+    };
+
+    static constexpr const char* environmentVariable = "KRUSH_TRACE";
+    static constexpr int ringSize = 1 << 17;
+
+private:
+    struct Event
+    {
+        const char* name = nullptr;
+        juce::int64 ticks = 0;
+        juce::uint32 threadID = 0;
+        juce::int32 instance = 0;
+        Phase phase = Phase::instant;
+    };
+
+    // Ready to be read when the sequence is one past its position in the ring.
+    struct Slot
+    {
+        std::atomic<juce::uint64> sequence{0};
+        Event event;
+    };
+
+    static constexpr int flushIntervalMs = 10;
+
+    static juce::File getOutputFile();
+    static juce::uint32 getThreadID() noexcept;
+
+    void run() override;
+    void drain();
+    void writeEvent(const Event& event);
+
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<juce::uint64> writePosition{0};
+    juce::uint64 readPosition = 0;
+    std::atomic<juce::int64> numDropped{0};
+
+    std::unique_ptr<juce::FileOutputStream> output;
+    juce::uint32 processID = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TraceRecorder)
+};
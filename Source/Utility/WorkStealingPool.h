@@ -0,0 +1,95 @@
+#pragma once
+#include "juce_core/juce_core.h"
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+  Runs a fixed list of jobs on a set of worker threads. The jobs are dealt out round robin
+  up front; each worker takes from the back of its own queue and, once that is empty,
+  steals from the front of the others. Long jobs (a long stem) therefore don't hold up the
+  short ones queued behind them, and nothing is shared per job but one queue lock.
+
+  run() blocks until every job has finished. The job function is called with the job
+  index and the index of the worker running it, so callers can keep per-worker state.
+ */
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(int threads)
+        : numThreads(juce::jmax(1, threads)), queues((size_t) numThreads)
+    {
+    }
+
+    int getNumThreads() const { return numThreads; }
+
+    void run(int numJobs, const std::function<void(int job, int worker)>& job)
+    {
+        for (int i = 0; i < numJobs; ++i)
+            queues[(size_t) (i % numThreads)].jobs.push_back(i);
+
+        std::vector<std::thread> workers;
+        for (int w = 1; w < numThreads; ++w)
+            workers.emplace_back([this, w, &job] { work(w, job); });
+
+        work(0, job);
+
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex lock;
+        std::deque<int> jobs;
+    };
+
+    void work(int worker, const std::function<void(int, int)>& job)
+    {
+        for (;;)
+        {
+            const auto next = takeJob(worker);
+            if (next < 0)
+                return;
+
+            job(next, worker);
+        }
+    }
+
+    // No job adds jobs, so once every queue is empty the pool is done.
+    int takeJob(int worker)
+    {
+        {
+            auto& own = queues[(size_t) worker];
+            const std::lock_guard<std::mutex> lock(own.lock);
+            if (!own.jobs.empty())
+            {
+                const auto job = own.jobs.back();
+                own.jobs.pop_back();
+                return job;
+            }
+        }
+
+        for (int offset = 1; offset < numThreads; ++offset)
+        {
+            auto& victim = queues[(size_t) ((worker + offset) % numThreads)];
+            const std::lock_guard<std::mutex> lock(victim.lock);
+            if (!victim.jobs.empty())
+            {
+                const auto job = victim.jobs.front();
+                victim.jobs.pop_front();
+                return job;
+            }
+        }
+
+        return -1;
+    }
+
+    int numThreads;
+    std::vector<Queue> queues;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WorkStealingPool)
+};
@@ -10,12 +10,71 @@
 
 #include "overSampleGain.h"
 
-void overSampleGain::process(juce::dsp::AudioBlock<float>& block, float setGain, int channel)
+void overSampleGain::prepare(int numChannels, int maxBlockSize)
 {
-    auto data = block.getChannelPointer(channel);
+    for (size_t i = 0; i < oversamplers.size(); ++i)
+    {
+        // Linear phase with a whole sample latency, so it can be compensated with the FFT's.
+        oversamplers[i] = std::make_unique<juce::dsp::Oversampling<float>>((size_t) numChannels, i + 1,
+                                                                           juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple,
+                                                                           true, true);
+        oversamplers[i]->initProcessing((size_t) maxBlockSize);
+    }
+}
+
+void overSampleGain::reset()
+{
+    for (auto& oversampler : oversamplers)
+        if (oversampler != nullptr)
+            oversampler->reset();
+}
+
+void overSampleGain::setFactorIndex(int newFactorIndex)
+{
+    newFactorIndex = juce::jlimit(0, maxFactorIndex, newFactorIndex);
+    if (newFactorIndex == factorIndex)
+        return;
+
+    factorIndex = newFactorIndex;
+    if (factorIndex > 0)
+        oversamplers[(size_t) factorIndex - 1]->reset();
+}
+
+int overSampleGain::getLatencyInSamples() const
+{
+    if (factorIndex == 0 || oversamplers[(size_t) factorIndex - 1] == nullptr)
+        return 0;
+
+    return juce::roundToInt(oversamplers[(size_t) factorIndex - 1]->getLatencyInSamples());
+}
+
+void overSampleGain::process(juce::dsp::AudioBlock<float>& block, float setGain, bool softClip)
+{
+    const auto gain = juce::Decibels::decibelsToGain(setGain);
+
+    if (factorIndex == 0)
+    {
+        applyGain(block, gain, softClip);
+        return;
+    }
+
+    auto& oversampler = *oversamplers[(size_t) factorIndex - 1];
+    auto oversampled = oversampler.processSamplesUp(block);
+    applyGain(oversampled, gain, softClip);
+    oversampler.processSamplesDown(block);
+}
+
+void overSampleGain::applyGain(juce::dsp::AudioBlock<float>& block, float gain, bool softClip)
+{
+    block.multiplyBy(gain);
+
+    if (!softClip)
+        return;
 
-    for (int s = 0; s < block.getNumSamples(); s++) //In Gain
+    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
     {
-        data[s] *= juce::Decibels::decibelsToGain(setGain);
+        auto* data = block.getChannelPointer(channel);
+        for (size_t s = 0; s < block.getNumSamples(); ++s)
+            data[s] = std::tanh(data[s]);
     }
 }
@@ -11,7 +11,30 @@
 #pragma once
 #include <juce_dsp/juce_dsp.h>
 
-struct overSampleGain
+/*
+  The output gain, with an optional soft clip, run at 1x, 2x, 4x or 8x through
+  juce::dsp::Oversampling's polyphase half-band FIRs. Every rate is built in prepare(), so
+  switching factors on the audio thread only resets the stage; the new latency still has
+  to be reported from the message thread.
+ */
+class overSampleGain
 {
-    void process(juce::dsp::AudioBlock<float>& block, float setGain, int channel);
-};
\ No newline at end of file
+public:
+    static constexpr int maxFactorIndex = 3;
+
+    void prepare(int numChannels, int maxBlockSize);
+    void reset();
+
+    // 0 for no oversampling, then 2x, 4x and 8x.
+    void setFactorIndex(int newFactorIndex);
+    int getFactorIndex() const { return factorIndex; }
+    int getLatencyInSamples() const;
+
+    void process(juce::dsp::AudioBlock<float>& block, float setGain, bool softClip);
+
+private:
+    static void applyGain(juce::dsp::AudioBlock<float>& block, float gain, bool softClip);
+
+    std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, maxFactorIndex> oversamplers;
+    int factorIndex = 0;
+};